@@ -1,10 +1,44 @@
 #include "apimanager.h"
+#include "entitystore.h"
+#include "cbordecoder.h"
+#include "endpointselector.h"
 #include <QNetworkRequest>
 #include <QJsonParseError>
 #include <QDebug>
 #include <QFile>
 #include <QTextStream>
 #include <QJsonDocument>
+#include <QDateTime>
+#include <QTimer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QUrlQuery>
+#include <QRandomGenerator>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+#include <utility>
+
+namespace {
+
+// 重试退避的基准与上限
+const int BaseBackoffMs = 500;
+const int MaxBackoffMs = 30 * 1000;
+
+// Retry-After超过该值时不再等待，直接返回错误
+const int MaxRetryAfterMs = 60 * 1000;
+
+// 重试预算：每个新请求补充0.1次，每次重试消耗1次，
+// 故障期间重试量不超过正常请求量的约10%，避免重试放大故障
+const double MaxRetryBudget = 10.0;
+const double RetryBudgetDeposit = 0.1;
+
+// 用户表格显示的字段（updated_at用于增量同步的水位线）
+const QStringList UserTableFields = {
+    "id", "username", "email", "full_name", "is_active", "roles", "created_at", "updated_at", "last_login"
+};
+
+}
 
 /**
  * API管理器构造函数
@@ -12,11 +46,306 @@
  */
 ApiManager::ApiManager(QObject *parent)
     : QObject(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_network(new NetworkThread(this))
     , m_baseUrl("http://localhost:8001/api")
+    , m_refreshTimer(new QTimer(this))
+    , m_refreshMarginMs(60 * 1000)
+    , m_refreshing(false)
+    , m_refreshEndpointMissing(false)
+    , m_endpoints(new EndpointSelector(this))
+    , m_entityStore(new EntityStore(this))
+    , m_timeoutMs(0)
+    , m_connectTimeoutMs(0)
+    , m_readTimeoutMs(0)
+    , m_nextBatchId(1)
+    , m_nextSyncId(1)
+    , m_nextRequestId(1)
+    , m_maxConnections(6)
+    , m_http2Enabled(true)
+    , m_http2Active(false)
+    , m_http2MaxStreams(20)
+    , m_tlsSessionReuse(true)
+    , m_interactiveReserve(2)
+    , m_schedulerPumpScheduled(false)
+    , m_rateLimit(50.0)
+    , m_maxRateLimit(50.0)
+    , m_rateBurst(10.0)
+    , m_rateTokens(10.0)
+    , m_rateUpdatedAt(0)
+    , m_backgroundLimit(1.0)
+    , m_latencyBaselineMs(0.0)
+    , m_lastDecreaseAt(0)
+    , m_backpressured(false)
+    , m_retryCount(0)
+    , m_retryBudget(MaxRetryBudget)
+    , m_compressRequests(true)
+    , m_compressThreshold(1024)
+    , m_compressionRejected(false)
+    , m_acceptCbor(true)
+    , m_batchEnvelope(true)
+    , m_batchSize(100)
+    , m_batchEndpointMissing(false)
+    , m_fieldProjection(true)
+    , m_projectionRejected(false)
+{
+    loadNetworkSettings();
+    loadCacheSettings();
+    
+    // 节点切换后新请求发往新节点，已排队或等待重试的请求在发出时改写地址
+    connect(m_endpoints, &EndpointSelector::activeChanged, this, &ApiManager::applyBaseUrl);
+    
+    m_refreshTimer->setSingleShot(true);
+    connect(m_refreshTimer, &QTimer::timeout, this, [this]() {
+        if (!m_refreshing && canRefreshToken()) {
+            refreshToken();
+        }
+    });
+}
+
+/**
+ * 读取网络配置（单位：秒）
+ */
+void ApiManager::loadNetworkSettings()
+{
+    QSettings settings;
+    m_timeoutMs = qMax(0, settings.value("server/timeout", 30).toInt()) * 1000;
+    m_connectTimeoutMs = qMax(0, settings.value("network/connection_timeout", 10).toInt()) * 1000;
+    m_readTimeoutMs = qMax(0, settings.value("network/read_timeout", 30).toInt()) * 1000;
+    m_retryCount = qMax(0, settings.value("network/retry_count", 3).toInt());
+    m_network->setTimeouts(m_timeoutMs, m_connectTimeoutMs, m_readTimeoutMs);
+    
+    // 令牌过期前多久刷新
+    m_refreshMarginMs = qMax(0, settings.value("auth/refresh_margin", 60).toInt()) * 1000;
+    
+    // 其他后端节点，与server/url一起按/health探测结果选择
+    m_extraBaseUrls = settings.value("server/urls").toStringList();
+    m_endpoints->setProbeInterval(settings.value("server/health_interval", 30).toInt());
+    
+    // QNetworkAccessManager对每个主机最多建立6个HTTP/1.1连接，超出的请求在其内部按先后排队
+    m_maxConnections = qMax(1, settings.value("network/max_connections", 6).toInt());
+    m_interactiveReserve = qBound(0, settings.value("network/interactive_reserve", 2).toInt(), m_maxConnections - 1);
+    
+    // HTTPS连接通过ALPN协商HTTP/2，服务端不支持时自动使用HTTP/1.1
+    m_http2Enabled = settings.value("network/http2", true).toBool();
+    m_http2MaxStreams = qMax(m_maxConnections, settings.value("network/http2_max_streams", 20).toInt());
+    m_tlsSessionReuse = settings.value("network/tls_session_reuse", true).toBool();
+    
+    // 后台请求速率上限（每秒请求数）与突发量；并发从较小值开始，按响应情况逐步增加
+    m_maxRateLimit = qMax(1.0, settings.value("network/rate_limit", 50).toDouble());
+    m_rateBurst = qMax(1.0, settings.value("network/rate_burst", 10).toDouble());
+    m_rateLimit = m_maxRateLimit;
+    m_rateTokens = m_rateBurst;
+    m_backgroundLimit = qMax(1.0, (m_maxConnections - m_interactiveReserve) / 2.0);
+    
+    // 请求体压缩（响应体的gzip/deflate由QNetworkAccessManager自动协商并解压）
+    m_compressRequests = settings.value("network/compress_requests", true).toBool();
+    m_compressThreshold = qMax(0, settings.value("network/compress_threshold", 1024).toInt());
+    
+    // 列表响应优先使用CBOR，解码时不必解析JSON文本
+    m_acceptCbor = settings.value("network/accept_cbor", true).toBool();
+    m_fieldProjection = settings.value("network/field_projection", true).toBool();
+    
+    // 批量操作打包提交，上千个小操作只需少数几次往返
+    m_batchEnvelope = settings.value("network/batch_envelope", true).toBool();
+    m_batchSize = qMax(1, settings.value("network/batch_size", 100).toInt());
+    
+    // 服务端对重复分配同一角色是幂等的，批量请求中的操作（角色分配/移除、激活状态）同样幂等；格式化是纯函数
+    m_retryablePostTypes << "assign_role" << "batch" << "format";
+    
+    qDebug() << "[DEBUG] ApiManager: timeouts (ms) total:" << m_timeoutMs
+             << "connect:" << m_connectTimeoutMs << "read:" << m_readTimeoutMs
+             << "retries:" << m_retryCount;
+}
+
+/**
+ * 允许指定类型的POST请求自动重试
+ */
+void ApiManager::setRetryPost(const QString &requestType, bool enabled)
+{
+    if (enabled) {
+        m_retryablePostTypes.insert(requestType);
+    } else {
+        m_retryablePostTypes.remove(requestType);
+    }
+}
+
+/**
+ * 为重试预算补充额度
+ */
+void ApiManager::depositRetryBudget()
+{
+    m_retryBudget = qMin(MaxRetryBudget, m_retryBudget + RetryBudgetDeposit);
+}
+
+/**
+ * 判断失败的请求是否重试
+ * 只重试临时故障（网络中断、超时、429/502/503/504），非幂等请求需显式允许，启动时的令牌验证不重试；
+ * 等待时间优先使用服务端的Retry-After，否则按指数退避取全抖动随机值
+ */
+int ApiManager::retryDelay(NetworkCall *reply, const QByteArray &method, const QString &requestType, int attempt)
+{
+    if (attempt >= m_retryCount || requestType == "session_check") {
+        return -1;
+    }
+    
+    bool idempotent = (method == "GET" || method == "PUT" || method == "DELETE" || method == "HEAD");
+    if (!idempotent && !m_retryablePostTypes.contains(requestType)) {
+        return -1;
+    }
+    
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    bool transient = false;
+    if (statusCode == 0) {
+        switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyConnectionClosedError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::UnknownNetworkError:
+            transient = true;
+            break;
+        case QNetworkReply::OperationCanceledError:
+            // 超时中止可以重试，调用方取消不会走到这里
+            transient = reply->timeoutKind() != NetworkResponse::NoTimeout;
+            break;
+        default:
+            break;
+        }
+    } else {
+        transient = (statusCode == 429 || statusCode == 502 || statusCode == 503 || statusCode == 504);
+    }
+    if (!transient) {
+        return -1;
+    }
+    
+    if (m_retryBudget < 1.0) {
+        qDebug() << "[DEBUG] Retry budget exhausted, not retrying" << reply->url().toString();
+        return -1;
+    }
+    
+    int delay = -1;
+    QByteArray retryAfter = reply->rawHeader("Retry-After").trimmed();
+    if (!retryAfter.isEmpty()) {
+        bool ok = false;
+        int seconds = retryAfter.toInt(&ok);
+        if (ok) {
+            delay = qMax(0, seconds) * 1000;
+        } else {
+            QDateTime at = QDateTime::fromString(QString::fromLatin1(retryAfter), Qt::RFC2822Date);
+            if (at.isValid()) {
+                delay = int(qBound(qint64(0), QDateTime::currentDateTimeUtc().msecsTo(at), qint64(MaxRetryAfterMs + 1)));
+            }
+        }
+        if (delay > MaxRetryAfterMs) {
+            qDebug() << "[DEBUG] Retry-After too long, not retrying" << reply->url().toString();
+            return -1;
+        }
+    }
+    if (delay < 0) {
+        int cap = qMin(MaxBackoffMs, BaseBackoffMs << qMin(attempt, 10));
+        delay = int(QRandomGenerator::global()->bounded(cap + 1));
+    }
+    
+    m_retryBudget -= 1.0;
+    qDebug() << "[DEBUG] Retrying" << method << reply->url().toString() << "attempt" << attempt + 1
+             << "in" << delay << "ms, status:" << statusCode;
+    return delay;
+}
+
+/**
+ * 取消所有进行中的请求
+ * 先收集句柄再逐个取消，取消过程中会修改在途请求表
+ */
+void ApiManager::cancelAll()
+{
+    QList<QPointer<ApiReply>> replies;
+    for (const PendingRequest &pending : std::as_const(m_pending)) {
+        replies.append(pending.subscribers);
+    }
+    for (const BatchState &batch : std::as_const(m_batches)) {
+        replies.append(batch.reply);
+    }
+    for (const SyncState &sync : std::as_const(m_syncs)) {
+        replies.append(sync.reply);
+    }
+    
+    qDebug() << "[DEBUG] ApiManager::cancelAll - canceling" << replies.size() << "requests";
+    for (const QPointer<ApiReply> &reply : replies) {
+        if (reply) {
+            reply->cancel();
+        }
+    }
+}
+
+/**
+ * 读取缓存配置
+ * 角色、权限列表很少变化，默认缓存时间较长；用户列表变化较频繁，默认缓存时间较短
+ */
+void ApiManager::loadCacheSettings()
+{
+    QSettings settings;
+    m_responseCache.setTtl("/roles/", settings.value("cache/roles_ttl", 300).toInt());
+    m_responseCache.setTtl("/permissions/", settings.value("cache/permissions_ttl", 600).toInt());
+    m_responseCache.setTtl("/users/", settings.value("cache/users_ttl", 60).toInt());
+    
+    // 磁盘层跨进程保留响应，重启后由QNetworkAccessManager自动发出条件请求
+    if (settings.value("cache/disk_enabled", false).toBool()) {
+        QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/http";
+        m_network->setDiskCache(directory, qint64(settings.value("cache/disk_max_mb", 50).toInt()) * 1024 * 1024);
+        qDebug() << "[DEBUG] ApiManager: disk cache enabled at" << directory;
+    }
+}
+
+/**
+ * 使缓存响应失效
+ */
+void ApiManager::invalidateCache(const QString &endpointPrefix)
+{
+    const QList<QUrl> urls = m_responseCache.invalidate(endpointPrefix);
+    if (endpointPrefix.isEmpty()) {
+        m_network->clearDiskCache();
+        return;
+    }
+    for (const QUrl &url : urls) {
+        m_network->removeFromDiskCache(url);
+    }
+}
+
+/**
+ * 权限列表首页结果写入本地实体存储，供下次启动时先行显示
+ */
+void ApiManager::updateEntityStore(const QString &requestType, const QUrl &url, const ApiResult &result)
+{
+    if (QUrlQuery(url).queryItemValue("skip").toInt() != 0) {
+        return;
+    }
+    
+    // 用户与角色目录由syncUsers/syncRoles维护
+    if (requestType == "permission_list") {
+        m_entityStore->setPermissions(result.value.value<QList<PermissionInfo>>());
+    }
+}
+
+/**
+ * 写操作成功后使受影响的缓存失效
+ */
+void ApiManager::invalidateAfterMutation(const QString &requestType)
 {
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, &ApiManager::onRequestFinished);
+    if (requestType == "create_role" || requestType == "update_role" || requestType == "delete_role") {
+        invalidateCache("/roles/");
+    } else if (requestType == "assign_role" || requestType == "remove_role") {
+        // 角色分配同时影响用户的角色列表
+        invalidateCache("/roles/");
+        invalidateCache("/users/");
+    } else if (requestType == "update_user" || requestType == "register") {
+        invalidateCache("/users/");
+    } else if (requestType == "login" || requestType == "logout" || requestType == "refresh_token") {
+        // 缓存键包含令牌，旧令牌的缓存不会再被使用
+        invalidateCache();
+    }
 }
 
 /**
@@ -24,50 +353,262 @@ ApiManager::ApiManager(QObject *parent)
  */
 void ApiManager::setBaseUrl(const QString &url)
 {
+    // 配置的其他节点与该地址一起参与健康检查与选择，该地址为首选节点
+    QStringList baseUrls{url};
+    for (const QString &extra : std::as_const(m_extraBaseUrls)) {
+        if (!baseUrls.contains(extra)) {
+            baseUrls.append(extra);
+        }
+    }
+    m_endpoints->setEndpoints(baseUrls);
+    applyBaseUrl(url);
+}
+
+/**
+ * 切换实际使用的基础URL
+ */
+void ApiManager::applyBaseUrl(const QString &url)
+{
+    if (url != m_baseUrl) {
+        m_compressionRejected = false;
+        m_projectionRejected = false;
+        m_batchEndpointMissing = false;
+        m_http2Active = false;
+        if (m_tlsSessionReuse) {
+            m_tlsSessions.open(QUrl(url));
+        }
+    }
     m_baseUrl = url;
 }
 
+/**
+ * 是否为连接层面的失败
+ */
+bool ApiManager::isConnectionFailure(NetworkCall *reply)
+{
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    case QNetworkReply::OperationCanceledError:
+        return reply->timeoutKind() == NetworkResponse::ConnectTimeout;
+    default:
+        return false;
+    }
+}
+
+/**
+ * 预先建立到服务器的连接
+ * 连接建立后留在QNetworkAccessManager的连接池中，后续请求直接复用
+ */
+void ApiManager::warmUp()
+{
+    QUrl url(m_baseUrl);
+    if (!url.isValid() || url.host().isEmpty()) {
+        return;
+    }
+    
+    qDebug() << "[DEBUG] ApiManager::warmUp -" << url.scheme() << url.host();
+#ifndef QT_NO_SSL
+    if (url.scheme() == "https") {
+        QNetworkRequest request(url);
+        applyTlsSession(request);
+        QSslConfiguration ssl = request.sslConfiguration();
+        if (m_http2Enabled) {
+            ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        }
+        m_network->connectToHostEncrypted(url.host(), quint16(url.port(443)), ssl);
+        return;
+    }
+#endif
+    m_network->connectToHost(url.host(), quint16(url.port(80)));
+}
+
 /**
  * 设置认证令牌
  */
 void ApiManager::setAuthToken(const QString &token)
 {
     m_authToken = token;
+    
+    // 登录后固定使用当前节点，只在故障时切换
+    m_endpoints->setSticky(!m_authToken.isEmpty());
+    
+    // 在过期前刷新；剩余有效期较短时提前量不超过剩余时间的一半
+    m_refreshTimer->stop();
+    qint64 expiresAt = tokenExpiry(token);
+    if (expiresAt > 0) {
+        qint64 remaining = expiresAt - QDateTime::currentMSecsSinceEpoch();
+        qint64 delay = remaining - qMin(qint64(m_refreshMarginMs), remaining / 2);
+        m_refreshTimer->start(int(qBound(qint64(1000), delay, qint64(24 * 60 * 60 * 1000))));
+        qDebug() << "[DEBUG] Token expires in" << remaining / 1000 << "s, refreshing in" << delay / 1000 << "s";
+    }
+}
+
+/**
+ * 设置用于静默重新登录的凭据
+ */
+void ApiManager::setCredentials(const QString &username, const QString &password)
+{
+    m_username = username;
+    m_password = password;
+}
+
+/**
+ * 从JWT中读取过期时间
+ */
+qint64 ApiManager::tokenExpiry(const QString &token)
+{
+    QStringList parts = token.split('.');
+    if (parts.size() != 3) {
+        return 0;
+    }
+    
+    QByteArray payload = QByteArray::fromBase64(parts[1].toLatin1(),
+                                                QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+    qint64 exp = qint64(QJsonDocument::fromJson(payload).object()["exp"].toDouble());
+    return exp > 0 ? exp * 1000 : 0;
+}
+
+/**
+ * 能否在收到401时刷新令牌
+ */
+bool ApiManager::canRefreshToken() const
+{
+    return !m_authToken.isEmpty() && (!m_refreshEndpointMissing || !m_password.isEmpty());
+}
+
+/**
+ * 刷新令牌
+ * 优先调用刷新接口；服务端没有该接口或拒绝刷新时，有凭据则静默重新登录
+ */
+void ApiManager::refreshToken()
+{
+    if (m_refreshEndpointMissing) {
+        reloginSilently();
+        return;
+    }
+    
+    m_refreshing = true;
+    qDebug() << "[DEBUG] Refreshing access token";
+    sendRequest("POST", "/auth/refresh", "refresh_token")->then(this, [this](ApiReply *reply) {
+        if (reply->isSuccess() && !reply->value<QString>().isEmpty()) {
+            finishTokenRefresh(true);
+            return;
+        }
+        
+        int statusCode = reply->statusCode();
+        if (statusCode == 404 || statusCode == 405 || statusCode == 501) {
+            qDebug() << "[DEBUG] No token refresh endpoint, falling back to silent re-login";
+            m_refreshEndpointMissing = true;
+        }
+        if (statusCode == 0) {
+            // 网络故障，稍后再试，挂起的请求继续等待
+            m_refreshing = false;
+            m_refreshTimer->start(30 * 1000);
+            return;
+        }
+        reloginSilently();
+    });
+}
+
+/**
+ * 用保存的凭据静默重新登录
+ */
+void ApiManager::reloginSilently()
+{
+    if (m_username.isEmpty() || m_password.isEmpty()) {
+        finishTokenRefresh(false);
+        return;
+    }
+    
+    m_refreshing = true;
+    qDebug() << "[DEBUG] Re-logging in silently as" << m_username;
+    login(m_username, m_password)->then(this, [this](ApiReply *reply) {
+        if (reply->statusCode() == 0) {
+            m_refreshing = false;
+            m_refreshTimer->start(30 * 1000);
+            return;
+        }
+        finishTokenRefresh(reply->isSuccess() && !reply->value<QString>().isEmpty());
+    });
+}
+
+/**
+ * 令牌刷新完成，继续或结束挂起的请求
+ */
+void ApiManager::finishTokenRefresh(bool refreshed)
+{
+    m_refreshing = false;
+    
+    if (refreshed) {
+        qDebug() << "[DEBUG] Access token refreshed, replaying" << m_authWaiters.size() << "requests";
+        emit tokenRefreshed(m_authToken);
+    } else if (!m_authWaiters.isEmpty() && !m_authToken.isEmpty()) {
+        // 已有请求因401失败且无法刷新，会话确实已过期
+        qDebug() << "[DEBUG] Token refresh failed, session expired";
+        setAuthToken(QString());
+        emit tokenExpired();
+    }
+    
+    const QList<std::function<void(bool)>> waiters = m_authWaiters;
+    m_authWaiters.clear();
+    for (const std::function<void(bool)> &resume : waiters) {
+        resume(refreshed);
+    }
+}
+
+/**
+ * 请求因401失败时挂起，等待令牌刷新
+ */
+void ApiManager::awaitTokenRefresh(const QByteArray &sentAuthorization, std::function<void(bool)> resume)
+{
+    if (!m_authToken.isEmpty() && sentAuthorization != "Bearer " + m_authToken.toUtf8()) {
+        // 请求发出后令牌已经更新，直接用新令牌重发
+        resume(true);
+        return;
+    }
+    
+    m_authWaiters.append(resume);
+    if (!m_refreshing) {
+        refreshToken();
+    }
 }
 
 /**
  * 用户登录请求
  */
-void ApiManager::login(const QString &username, const QString &password)
+ApiReply *ApiManager::login(const QString &username, const QString &password)
 {
     qDebug() << "[DEBUG] ApiManager::login called with username:" << username;
-    qDebug() << "[DEBUG] Password length:" << password.length();
     qDebug() << "[DEBUG] Base URL:" << m_baseUrl;
     
     QJsonObject loginData;
     loginData["username"] = username;
     loginData["password"] = password;
     
-    qDebug() << "[DEBUG] Login data prepared:" << loginData;
-    qDebug() << "[DEBUG] About to send POST request to /auth/login";
-    
-    sendPostRequest("/auth/login", loginData, "login");
-    qDebug() << "[DEBUG] POST request sent";
+    return sendRequest("POST", "/auth/login", "login", loginData);
 }
 
 /**
  * 用户登出
  */
-void ApiManager::logout()
+ApiReply *ApiManager::logout()
 {
-    sendPostRequest("/auth/logout", QJsonObject(), "logout");
-    m_authToken.clear();
+    ApiReply *reply = sendRequest("POST", "/auth/logout", "logout");
+    setAuthToken(QString());
+    setCredentials(QString(), QString());
+    return reply;
 }
 
 /**
  * 用户注册
  */
-void ApiManager::registerUser(const QString &username, const QString &email, const QString &password, const QString &fullName)
+ApiReply *ApiManager::registerUser(const QString &username, const QString &email, const QString &password, const QString &fullName)
 {
     QJsonObject data;
     data["username"] = username;
@@ -77,39 +618,70 @@ void ApiManager::registerUser(const QString &username, const QString &email, con
         data["full_name"] = fullName;
     }
     
-    sendPostRequest("/auth/register", data, "register");
+    return sendRequest("POST", "/auth/register", "register", data);
 }
 
 /**
  * 获取当前用户信息
  */
-void ApiManager::getCurrentUserInfo()
+ApiReply *ApiManager::getCurrentUserInfo()
 {
-    sendGetRequest("/users/me", "current_user");
+    return sendRequest("GET", "/users/me", "current_user");
+}
+
+/**
+ * 验证保存的令牌
+ * 用于启动时决定进入主窗口还是登录窗口：请求不重试，超过时限时取消请求并按失败完成，
+ * 服务器无法连接时不会在启动阶段长时间没有界面
+ */
+ApiReply *ApiManager::validateSession(int timeoutMs)
+{
+    ApiReply *apiReply = new ApiReply(this);
+    QPointer<ApiReply> request = sendRequest("GET", "/users/me", "session_check");
+    request->then(apiReply, [apiReply](ApiReply *reply) {
+        apiReply->resolve(reply->result());
+    });
+    
+    QTimer::singleShot(timeoutMs, apiReply, [apiReply, request]() {
+        qDebug() << "[DEBUG] Session validation timed out";
+        if (request) {
+            request->cancel();
+        }
+        ApiResult result;
+        result.error = "验证登录状态超时";
+        apiReply->resolve(result);
+    });
+    connect(apiReply, &ApiReply::canceled, this, [request]() {
+        if (request) {
+            request->cancel();
+        }
+    });
+    return apiReply;
 }
 
 /**
  * 获取用户列表
  */
-void ApiManager::getUserList(int skip, int limit)
+ApiReply *ApiManager::getUserList(int skip, int limit, const QStringList &fields)
 {
     QString endpoint = QString("/users/?skip=%1&limit=%2").arg(skip).arg(limit);
-    sendGetRequest(endpoint, "user_list");
+    endpoint += projectionQuery(fields, true);
+    return sendRequest("GET", endpoint, "user_list");
 }
 
 /**
  * 获取指定用户信息
  */
-void ApiManager::getUserInfo(int userId)
+ApiReply *ApiManager::getUserInfo(int userId)
 {
     QString endpoint = QString("/users/%1").arg(userId);
-    sendGetRequest(endpoint, "user_info");
+    return sendRequest("GET", endpoint, "user_info");
 }
 
 /**
  * 更新用户信息
  */
-void ApiManager::updateUser(int userId, const QString &email, const QString &fullName, bool isActive)
+ApiReply *ApiManager::updateUser(int userId, const QString &email, const QString &fullName, bool isActive)
 {
     QJsonObject data;
     if (!email.isEmpty()) {
@@ -121,31 +693,32 @@ void ApiManager::updateUser(int userId, const QString &email, const QString &ful
     data["is_active"] = isActive;
     
     QString endpoint = QString("/users/%1").arg(userId);
-    sendPutRequest(endpoint, data, "update_user");
+    return sendRequest("PUT", endpoint, "update_user", data);
 }
 
 /**
  * 获取角色列表
  */
-void ApiManager::getRoleList(int skip, int limit)
+ApiReply *ApiManager::getRoleList(int skip, int limit, bool includePermissions)
 {
     QString endpoint = QString("/roles/?skip=%1&limit=%2").arg(skip).arg(limit);
-    sendGetRequest(endpoint, "role_list");
+    endpoint += projectionQuery(QStringList(), includePermissions);
+    return sendRequest("GET", endpoint, "role_list");
 }
 
 /**
  * 获取指定角色信息
  */
-void ApiManager::getRoleInfo(int roleId)
+ApiReply *ApiManager::getRoleInfo(int roleId)
 {
     QString endpoint = QString("/roles/%1").arg(roleId);
-    sendGetRequest(endpoint, "role_info");
+    return sendRequest("GET", endpoint, "role_info");
 }
 
 /**
  * 创建角色
  */
-void ApiManager::createRole(const QString &name, const QString &displayName, const QString &description)
+ApiReply *ApiManager::createRole(const QString &name, const QString &displayName, const QString &description)
 {
     QJsonObject data;
     data["name"] = name;
@@ -154,13 +727,13 @@ void ApiManager::createRole(const QString &name, const QString &displayName, con
         data["description"] = description;
     }
     
-    sendPostRequest("/roles/", data, "create_role");
+    return sendRequest("POST", "/roles/", "create_role", data);
 }
 
 /**
  * 更新角色信息
  */
-void ApiManager::updateRole(int roleId, const QString &displayName, const QString &description, bool isActive)
+ApiReply *ApiManager::updateRole(int roleId, const QString &displayName, const QString &description, bool isActive)
 {
     QJsonObject data;
     if (!displayName.isEmpty()) {
@@ -172,67 +745,71 @@ void ApiManager::updateRole(int roleId, const QString &displayName, const QStrin
     data["is_active"] = isActive;
     
     QString endpoint = QString("/roles/%1").arg(roleId);
-    sendPutRequest(endpoint, data, "update_role");
+    return sendRequest("PUT", endpoint, "update_role", data);
 }
 
 /**
  * 删除角色
  */
-void ApiManager::deleteRole(int roleId)
+ApiReply *ApiManager::deleteRole(int roleId)
 {
     QString endpoint = QString("/roles/%1").arg(roleId);
-    sendDeleteRequest(endpoint, "delete_role");
+    ApiReply *reply = sendRequest("DELETE", endpoint, "delete_role");
+    
+    // 删除的记录不会出现在增量结果中，直接从本地存储移除
+    reply->then(this, [this, roleId](ApiReply *result) {
+        if (result->isSuccess()) {
+            m_entityStore->mergeRoles(QList<RoleInfo>(), QList<int>() << roleId, m_entityStore->rolesWatermark());
+        }
+    });
+    return reply;
 }
 
 /**
  * 为用户分配角色
  */
-void ApiManager::assignRoleToUser(int userId, int roleId)
+ApiReply *ApiManager::assignRoleToUser(int userId, int roleId)
 {
     QString endpoint = QString("/roles/users/%1/assign/%2").arg(userId).arg(roleId);
-    sendPostRequest(endpoint, QJsonObject(), "assign_role");
+    return sendRequest("POST", endpoint, "assign_role");
 }
 
 /**
  * 移除用户角色
  */
-void ApiManager::removeRoleFromUser(int userId, int roleId)
+ApiReply *ApiManager::removeRoleFromUser(int userId, int roleId)
 {
     QString endpoint = QString("/roles/users/%1/remove/%2").arg(userId).arg(roleId);
-    sendDeleteRequest(endpoint, "remove_role");
+    return sendRequest("DELETE", endpoint, "remove_role");
 }
 
 /**
  * 格式化字符串请求
  */
-void ApiManager::formatString(const QString &input, const QString &formatType)
+ApiReply *ApiManager::formatString(const QString &input, const QString &formatType)
 {
     QJsonObject data;
     data["input"] = input;
     data["type"] = formatType;
     
-    sendPostRequest("/tools/format-string", data, "format");
+    return sendRequest("POST", "/tools/format-string", "format", data);
 }
 
 /**
  * 获取权限列表
  */
-void ApiManager::getPermissionList(int skip, int limit)
+ApiReply *ApiManager::getPermissionList(int skip, int limit)
 {
     QString endpoint = QString("/permissions/?skip=%1&limit=%2").arg(skip).arg(limit);
-    sendGetRequest(endpoint, "permission_list");
+    return sendRequest("GET", endpoint, "permission_list");
 }
 
 /**
- * 发送POST请求
+ * 构造带认证头的请求
  */
-void ApiManager::sendPostRequest(const QString &endpoint, const QJsonObject &data, const QString &requestType)
+QNetworkRequest ApiManager::buildRequest(const QString &endpoint, const QString &requestType) const
 {
     QUrl url(m_baseUrl + endpoint);
-    qDebug() << "[DEBUG] sendPostRequest - Full URL:" << url.toString();
-    qDebug() << "[DEBUG] sendPostRequest - Request type:" << requestType;
-    qDebug() << "[DEBUG] sendPostRequest - Data:" << data;
-    
     QNetworkRequest request(url);
     
     // 设置请求头
@@ -241,395 +818,1552 @@ void ApiManager::sendPostRequest(const QString &endpoint, const QJsonObject &dat
     // 如果有认证令牌，添加到请求头
     if (!m_authToken.isEmpty()) {
         request.setRawHeader("Authorization", ("Bearer " + m_authToken).toUtf8());
-        qDebug() << "[DEBUG] sendPostRequest - Added auth token";
     }
     
-    // 设置请求类型标识
-    request.setAttribute(QNetworkRequest::User, requestType);
+    // 列表类响应数据量大，优先协商CBOR，服务端不支持时返回JSON
+    if (m_acceptCbor && (requestType == "user_list" || requestType == "role_list"
+                         || requestType == "permission_list" || requestType == "user_sync" || requestType == "role_sync")) {
+        request.setRawHeader("Accept", "application/cbor, application/json;q=0.9");
+    }
     
-    // 转换数据为JSON
-    QJsonDocument doc(data);
-    QByteArray jsonData = doc.toJson();
-    qDebug() << "[DEBUG] sendPostRequest - JSON data:" << jsonData;
+    // 允许通过ALPN协商HTTP/2（Qt 5默认关闭）
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, m_http2Enabled);
     
-    // 发送请求
-    QNetworkReply *reply = m_networkManager->post(request, jsonData);
-    qDebug() << "[DEBUG] sendPostRequest - Request sent, reply object created";
+    // 设置请求类型标识
+    request.setAttribute(QNetworkRequest::User, requestType);
     
-    // 连接信号
-    connect(reply, &QNetworkReply::finished, [this, reply, requestType]() {
-        handleResponse(reply, requestType);
-    });
-    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &ApiManager::onNetworkError);
-    qDebug() << "[DEBUG] sendPostRequest - Signals connected";
+    applyTlsSession(request);
+    return request;
 }
 
 /**
- * 发送GET请求
+ * 为HTTPS请求附加TLS配置
+ * 开启会话持久化，握手后才能从响应中取得会话票据；有未过期的票据时带上以恢复会话
  */
-void ApiManager::sendGetRequest(const QString &endpoint, const QString &requestType)
+void ApiManager::applyTlsSession(QNetworkRequest &request) const
 {
-    QUrl url(m_baseUrl + endpoint);
-    QNetworkRequest request(url);
-    
-    // 设置请求头
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    
-    // 如果有认证令牌，添加到请求头
-    if (!m_authToken.isEmpty()) {
-        request.setRawHeader("Authorization", ("Bearer " + m_authToken).toUtf8());
+#ifndef QT_NO_SSL
+    if (!m_tlsSessionReuse || request.url().scheme() != "https") {
+        return;
     }
     
-    // 设置请求类型标识
-    request.setAttribute(QNetworkRequest::User, requestType);
-    
-    // 发送请求
-    QNetworkReply *reply = m_networkManager->get(request);
-    qDebug() << "[DEBUG] sendGetRequest - Request sent";
-    
-    // 连接信号
-    connect(reply, &QNetworkReply::finished, [this, reply, requestType]() {
-        handleResponse(reply, requestType);
-    });
-    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &ApiManager::onNetworkError);
+    QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+    ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    QByteArray session = m_tlsSessions.session();
+    if (!session.isEmpty()) {
+        ssl.setSessionTicket(session);
+    }
+    request.setSslConfiguration(ssl);
+#else
+    Q_UNUSED(request);
+#endif
 }
 
 /**
- * 发送PUT请求
+ * 按HTTP方法发出请求
+ * 请求在网络线程中发出，超时也在网络线程中计时，界面线程繁忙不会推迟套接字读写
  */
-void ApiManager::sendPutRequest(const QString &endpoint, const QJsonObject &data, const QString &requestType)
+NetworkCall *ApiManager::dispatchRequest(const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+                                         const QString &requestType)
 {
-    QUrl url(m_baseUrl + endpoint);
-    QNetworkRequest request(url);
-    
-    // 设置请求头
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    
-    // 如果有认证令牌，添加到请求头
-    if (!m_authToken.isEmpty()) {
-        request.setRawHeader("Authorization", ("Bearer " + m_authToken).toUtf8());
+    // 响应体在网络线程中解码为类型化结果，界面线程只更新会话状态并分发结果
+    NetworkThread::Decoder decode;
+    if (!requestType.isEmpty()) {
+        decode = [requestType](const NetworkResponse &response) {
+            int statusCode = response.attributes.value(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            return QVariant::fromValue(parseResponse(statusCode, response.body, response.rawHeader("Content-Type"),
+                                                     requestType, response.displayError()));
+        };
     }
+    NetworkCall *reply = m_network->send(method, request, body, decode);
     
-    // 设置请求类型标识
-    request.setAttribute(QNetworkRequest::User, requestType);
-    
-    // 转换数据为JSON
-    QJsonDocument doc(data);
-    QByteArray jsonData = doc.toJson();
-    
-    // 发送请求
-    QNetworkReply *reply = m_networkManager->put(request, jsonData);
-    
-    // 连接信号
-    connect(reply, &QNetworkReply::finished, [this, reply, requestType]() {
-        handleResponse(reply, requestType);
-    });
-    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &ApiManager::onNetworkError);
+    // 记录服务端下发的会话票据（网络线程在请求结束时读取）
+    if (m_tlsSessionReuse && request.url().scheme() == "https") {
+        connect(reply, &NetworkCall::finished, this, [this, reply]() {
+            m_tlsSessions.store(reply->sessionTicket(), reply->sessionTicketLifetimeHint());
+        });
+    }
+    return reply;
 }
 
 /**
- * 发送DELETE请求
+ * 生成字段投影查询参数
  */
-void ApiManager::sendDeleteRequest(const QString &endpoint, const QString &requestType)
+QString ApiManager::projectionQuery(const QStringList &fields, bool includePermissions) const
 {
-    QUrl url(m_baseUrl + endpoint);
-    QNetworkRequest request(url);
-    
-    // 设置请求头
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    
-    // 如果有认证令牌，添加到请求头
-    if (!m_authToken.isEmpty()) {
-        request.setRawHeader("Authorization", ("Bearer " + m_authToken).toUtf8());
+    if (!m_fieldProjection || m_projectionRejected) {
+        return QString();
     }
     
-    // 设置请求类型标识
-    request.setAttribute(QNetworkRequest::User, requestType);
+    QString query;
+    if (!fields.isEmpty()) {
+        query += "&fields=" + fields.join(',');
+    }
+    if (!includePermissions) {
+        query += "&include_permissions=false";
+    }
+    return query;
+}
+
+/**
+ * 按配置压缩请求体
+ * qCompress输出的是zlib格式（即HTTP的deflate编码），去掉Qt前置的4字节长度即可直接发送
+ */
+bool ApiManager::compressBody(QNetworkRequest &request, QByteArray &body) const
+{
+    if (!m_compressRequests || m_compressionRejected || body.size() < m_compressThreshold) {
+        return false;
+    }
+    
+    QByteArray compressed = qCompress(body).mid(4);
+    if (compressed.size() >= body.size()) {
+        return false;
+    }
+    
+    request.setRawHeader("Content-Encoding", "deflate");
+    body = compressed;
+    return true;
+}
+
+/**
+ * 发送请求并返回请求句柄
+ * 相同的GET请求（端点、查询参数与令牌一致）正在进行时不再重复发出，
+ * 新的调用方挂到已有请求上，收到同一份解码结果
+ */
+ApiReply *ApiManager::sendRequest(const QByteArray &method, const QString &endpoint, const QString &requestType,
+                                  const QJsonObject &data, Priority priority)
+{
+    QNetworkRequest request = buildRequest(endpoint, requestType);
+    ApiReply *apiReply = new ApiReply(this);
     
-    // 发送请求
-    QNetworkReply *reply = m_networkManager->deleteResource(request);
+    // 配置了有效期的GET请求先查缓存：未过期直接返回，已过期带验证器发出条件请求；
+    // 同步页总是从服务器获取，否则水位未变时轮询与推送触发的同步会拿到缓存的旧页；
+    // 令牌验证同样不能用缓存的结果
+    QString path = endpoint.section('?', 0, 0);
+    QString cacheKey;
+    if (requestType == "user_sync" || requestType == "role_sync" || requestType == "session_check") {
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+        request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+    } else if (method == "GET" && m_responseCache.ttlFor(path) > 0) {
+        cacheKey = requestKey(request);
+        ResponseCache::Entry entry;
+        if (m_responseCache.lookup(cacheKey, &entry)) {
+            if (ResponseCache::isFresh(entry)) {
+                qDebug() << "[DEBUG] sendRequest - cache hit" << m_baseUrl + endpoint;
+                ApiResult result = decodeResponse(200, entry.body, entry.contentType, requestType, QString());
+                QMetaObject::invokeMethod(apiReply, [apiReply, result]() {
+                    apiReply->resolve(result);
+                }, Qt::QueuedConnection);
+                return apiReply;
+            }
+            
+            if (!entry.etag.isEmpty()) {
+                request.setRawHeader("If-None-Match", entry.etag);
+            }
+            if (!entry.lastModified.isEmpty()) {
+                request.setRawHeader("If-Modified-Since", entry.lastModified);
+            }
+            // 自行处理304，不让磁盘缓存层改写条件请求
+            request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+        }
+    }
+    
+    QString key = coalesceKey(method, request);
+    if (!key.isEmpty()) {
+        auto inFlight = m_inFlightGets.constFind(key);
+        if (inFlight != m_inFlightGets.constEnd()) {
+            qDebug() << "[DEBUG] sendRequest - coalesced with in-flight" << method << m_baseUrl + endpoint;
+            int requestId = inFlight.value();
+            attachSubscriber(requestId, apiReply);
+            
+            // 交互请求合并到仍在排队的后台请求时，提升该请求的优先级
+            PendingRequest &pending = m_pending[requestId];
+            if (priority == Interactive && pending.priority == Background) {
+                pending.priority = Interactive;
+                if (pending.queued) {
+                    dispatchPending(requestId);
+                }
+            }
+            return apiReply;
+        }
+    }
     
-    // 连接信号
-    connect(reply, &QNetworkReply::finished, [this, reply, requestType]() {
-        handleResponse(reply, requestType);
+    qDebug() << "[DEBUG] sendRequest -" << method << m_baseUrl + endpoint << "type:" << requestType;
+    
+    int requestId = m_nextRequestId++;
+    PendingRequest &pending = m_pending[requestId];
+    pending.priority = priority;
+    pending.method = method;
+    pending.request = request;
+    if (method == "POST" || method == "PUT") {
+        pending.body = QJsonDocument(data).toJson(QJsonDocument::Compact);
+        QByteArray plainBody = pending.body;
+        if (compressBody(pending.request, pending.body)) {
+            pending.plainBody = plainBody;
+        }
+    }
+    pending.requestType = requestType;
+    pending.coalesceKey = key;
+    pending.cacheKey = cacheKey;
+    pending.path = path;
+    if (!key.isEmpty()) {
+        m_inFlightGets.insert(key, requestId);
+    }
+    
+    attachSubscriber(requestId, apiReply);
+    depositRetryBudget();
+    dispatchPending(requestId);
+    
+    return apiReply;
+}
+
+/**
+ * 发出（或重新发出）在途请求
+ */
+void ApiManager::dispatchPending(int requestId)
+{
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    
+    // 同一请求可能因优先级提升在两个队列中各有一个任务，先执行的任务发出请求
+    it->queued = true;
+    scheduleDispatch(it->priority, [this, requestId]() -> NetworkCall * {
+        auto pending = m_pending.find(requestId);
+        if (pending == m_pending.end() || !pending->queued) {
+            return nullptr;
+        }
+        pending->queued = false;
+        pending->request.setUrl(m_endpoints->rebase(pending->request.url()));
+        
+        NetworkCall *reply = dispatchRequest(pending->method, pending->request, pending->body, pending->requestType);
+        pending->reply = reply;
+        connect(reply, &NetworkCall::finished, this, [this, requestId, reply]() {
+            handleResponse(requestId, reply);
+        });
+        return reply;
     });
-    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &ApiManager::onNetworkError);
 }
 
 /**
- * 处理网络请求完成
+ * 将发出请求的任务加入对应优先级的队列
  */
-void ApiManager::onRequestFinished()
+void ApiManager::scheduleDispatch(Priority priority, std::function<NetworkCall*()> job)
 {
-    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply) {
+    m_lanes[priority].queue.append(job);
+    if (priority == Background) {
+        updateBackpressure();
+    }
+    pumpScheduler();
+}
+
+/**
+ * 在并发限制内从队列中发出请求
+ * 交互队列非空时后台队列不出队，排队中的后台请求让位于新到的交互请求；
+ * 已发出的后台请求不会被中断
+ */
+void ApiManager::pumpScheduler()
+{
+    Lane &interactive = m_lanes[Interactive];
+    Lane &background = m_lanes[Background];
+    
+    for (;;) {
+        int inFlight = interactive.inFlight + background.inFlight;
+        Priority priority;
+        if (!interactive.queue.isEmpty()) {
+            if (inFlight >= connectionLimit()) {
+                return;
+            }
+            priority = Interactive;
+        } else if (!background.queue.isEmpty()) {
+            if (inFlight >= connectionLimit() - m_interactiveReserve
+                || background.inFlight >= int(m_backgroundLimit)) {
+                return;
+            }
+            int waitMs = takeRateToken();
+            if (waitMs > 0) {
+                // 令牌不足，等到下一个令牌生成时再继续
+                if (!m_schedulerPumpScheduled) {
+                    m_schedulerPumpScheduled = true;
+                    QTimer::singleShot(waitMs, this, [this]() {
+                        m_schedulerPumpScheduled = false;
+                        pumpScheduler();
+                    });
+                }
+                return;
+            }
+            priority = Background;
+        } else {
+            return;
+        }
+        
+        std::function<NetworkCall*()> job = m_lanes[priority].queue.takeFirst();
+        updateBackpressure();
+        NetworkCall *reply = job();
+        if (!reply) {
+            if (priority == Background) {
+                // 请求已取消，退还令牌
+                m_rateTokens = qMin(m_rateBurst, m_rateTokens + 1.0);
+            }
+            continue;
+        }
+        
+        m_lanes[priority].inFlight++;
+        qint64 startedAt = QDateTime::currentMSecsSinceEpoch();
+        connect(reply, &NetworkCall::finished, this, [this, priority, reply, startedAt]() {
+            m_lanes[priority].inFlight--;
+            if (!m_http2Active && reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+                qDebug() << "[DEBUG] HTTP/2 in use, raising concurrency limit to" << m_http2MaxStreams;
+                m_http2Active = true;
+            }
+            adaptRateLimit(priority, QDateTime::currentMSecsSinceEpoch() - startedAt,
+                           reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt());
+            pumpScheduler();
+        });
+    }
+}
+
+/**
+ * 当前的并发请求上限
+ */
+int ApiManager::connectionLimit() const
+{
+    return m_http2Active ? m_http2MaxStreams : m_maxConnections;
+}
+
+/**
+ * 取一个后台请求令牌
+ * 令牌按当前速率持续生成，最多累积到突发量
+ */
+int ApiManager::takeRateToken()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_rateUpdatedAt > 0) {
+        m_rateTokens = qMin(m_rateBurst, m_rateTokens + (now - m_rateUpdatedAt) * m_rateLimit / 1000.0);
+    }
+    m_rateUpdatedAt = now;
+    
+    if (m_rateTokens >= 1.0) {
+        m_rateTokens -= 1.0;
+        return 0;
+    }
+    return qMax(1, int((1.0 - m_rateTokens) * 1000.0 / m_rateLimit) + 1);
+}
+
+/**
+ * 根据请求结果调整后台并发上限与速率
+ * 429/503或延迟超过基线两倍视为过载，乘性减半（每秒最多一次，避免同一批在途请求连续减半）；
+ * 后台请求正常完成时加性增加，每轮并发窗口约增加1
+ */
+void ApiManager::adaptRateLimit(Priority priority, qint64 latencyMs, int statusCode)
+{
+    bool throttled = (statusCode == 429 || statusCode == 503);
+    bool ok = (statusCode >= 200 && statusCode < 400);
+    
+    // 延迟基线：下降立即跟随，上升缓慢跟随，适应服务端正常的负载变化
+    if (ok) {
+        if (m_latencyBaselineMs <= 0.0 || latencyMs < m_latencyBaselineMs) {
+            m_latencyBaselineMs = latencyMs;
+        } else {
+            m_latencyBaselineMs += (latencyMs - m_latencyBaselineMs) * 0.01;
+        }
+    }
+    bool slow = ok && latencyMs > 200 && latencyMs > m_latencyBaselineMs * 2.0;
+    
+    double maxLimit = qMax(1, connectionLimit() - m_interactiveReserve);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (throttled || slow) {
+        if (now - m_lastDecreaseAt >= 1000) {
+            m_lastDecreaseAt = now;
+            m_backgroundLimit = qMax(1.0, m_backgroundLimit / 2.0);
+            m_rateLimit = qMax(1.0, m_rateLimit / 2.0);
+            qDebug() << "[DEBUG] Backing off background traffic:" << (throttled ? "throttled" : "slow")
+                     << "status:" << statusCode << "latency:" << latencyMs << "ms"
+                     << "-> concurrency" << m_backgroundLimit << "rate" << m_rateLimit << "/s";
+        }
+    } else if (ok && priority == Background) {
+        m_backgroundLimit = qMin(maxLimit, m_backgroundLimit + 1.0 / m_backgroundLimit);
+        m_rateLimit = qMin(m_maxRateLimit, m_rateLimit + 1.0 / m_backgroundLimit);
+    }
+}
+
+/**
+ * 更新背压状态
+ * 排队的后台请求超过当前并发上限的两倍时进入背压，队列排空到一半以下时解除
+ */
+void ApiManager::updateBackpressure()
+{
+    int queued = m_lanes[Background].queue.size();
+    int high = qMax(4, int(m_backgroundLimit) * 2);
+    
+    bool backpressured = m_backpressured ? queued > high / 2 : queued >= high;
+    if (backpressured == m_backpressured) {
         return;
     }
     
-    QString requestType = reply->request().attribute(QNetworkRequest::User).toString();
-    handleResponse(reply, requestType);
+    m_backpressured = backpressured;
+    qDebug() << "[DEBUG] Background backpressure" << (backpressured ? "on" : "off") << "queued:" << queued;
+    emit backpressureChanged(backpressured);
     
-    reply->deleteLater();
+    if (!backpressured) {
+        // 继续推进因背压暂停的批次（延后执行，避免在调度过程中重入）
+        QTimer::singleShot(0, this, [this]() {
+            const QList<int> batchIds = m_batches.keys();
+            for (int batchId : batchIds) {
+                pumpBatch(batchId);
+            }
+        });
+    }
+}
+
+/**
+ * 结束在途请求，移出合并表
+ * 先移出合并表，回调中再次发起的相同请求会重新发出
+ */
+ApiManager::PendingRequest ApiManager::takePending(int requestId)
+{
+    PendingRequest pending = m_pending.take(requestId);
+    if (!pending.coalesceKey.isEmpty() && m_inFlightGets.value(pending.coalesceKey) == requestId) {
+        m_inFlightGets.remove(pending.coalesceKey);
+    }
+    return pending;
+}
+
+/**
+ * 计算GET请求的合并键，非GET请求返回空字符串（不合并）
+ */
+QString ApiManager::coalesceKey(const QByteArray &method, const QNetworkRequest &request) const
+{
+    if (method != "GET") {
+        return QString();
+    }
+    return QString::fromLatin1(method) + ' ' + requestKey(request);
 }
 
 /**
- * 处理网络错误
+ * 请求标识：完整URL（含查询参数）与令牌
  */
-void ApiManager::onNetworkError(QNetworkReply::NetworkError error)
+QString ApiManager::requestKey(const QNetworkRequest &request) const
 {
-    qDebug() << "[DEBUG] onNetworkError called with error code:" << error;
-    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    return request.url().toString(QUrl::FullyEncoded)
+           + '\n' + QString::fromLatin1(request.rawHeader("Authorization"));
+}
+
+/**
+ * 将请求句柄挂到在途请求上
+ */
+void ApiManager::attachSubscriber(int requestId, ApiReply *apiReply)
+{
+    m_pending[requestId].subscribers.append(apiReply);
+    
+    connect(apiReply, &ApiReply::canceled, this, [this, requestId, apiReply]() {
+        detachSubscriber(requestId, apiReply);
+    });
+}
+
+/**
+ * 移除已取消的请求句柄，没有调用方等待时中止网络请求，释放连接
+ */
+void ApiManager::detachSubscriber(int requestId, ApiReply *apiReply)
+{
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    
+    QList<QPointer<ApiReply>> &subscribers = it->subscribers;
+    for (int i = subscribers.size() - 1; i >= 0; --i) {
+        if (subscribers[i].isNull() || subscribers[i] == apiReply) {
+            subscribers.removeAt(i);
+        }
+    }
+    
+    if (!subscribers.isEmpty()) {
+        return;
+    }
+    
+    qDebug() << "[DEBUG] Request canceled by caller:" << it->request.url().toString();
+    
+    // 立即结束（仍在排队或等待重试时队列中的任务会被跳过）；已发出的请求在网络线程中异步中止，
+    // 中止完成前相同的GET不会再合并到这个请求上
+    NetworkCall *reply = it->reply;
+    takePending(requestId);
     if (reply) {
-        QString errorString = reply->errorString();
-        qDebug() << "[DEBUG] Network error string:" << errorString;
-        qDebug() << "[DEBUG] Request URL:" << reply->url().toString();
-        qDebug() << "[DEBUG] HTTP status code:" << reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        emit networkError(errorString);
-        qDebug() << "[DEBUG] networkError signal emitted";
+        reply->abort();
+    }
+}
+
+/**
+ * 增量同步用户目录
+ */
+ApiReply *ApiManager::syncUsers(Priority priority)
+{
+    return startSync("/users/", priority);
+}
+
+/**
+ * 增量同步角色目录
+ */
+ApiReply *ApiManager::syncRoles(Priority priority)
+{
+    return startSync("/roles/", priority);
+}
+
+/**
+ * 开始同步指定端点的实体目录
+ * 带updated_since参数请求高水位之后变化的记录，支持增量的服务端返回
+ * {"items": [...], "deleted_ids": [...]}；不认识该参数的服务端会返回普通列表，此时按全量结果处理
+ */
+ApiReply *ApiManager::startSync(const QString &path, Priority priority)
+{
+    ApiReply *apiReply = new ApiReply(this);
+    
+    int syncId = m_nextSyncId++;
+    SyncState state;
+    state.reply = apiReply;
+    state.path = path;
+    state.priority = priority;
+    state.since = (path == "/users/") ? m_entityStore->usersWatermark() : m_entityStore->rolesWatermark();
+    state.delta = !state.since.isEmpty();
+    m_syncs.insert(syncId, state);
+    
+    qDebug() << "[DEBUG] startSync -" << path << "since:" << (state.delta ? state.since : QString("(full)"));
+    
+    fetchSyncPage(syncId);
+    return apiReply;
+}
+
+/**
+ * 请求同步的下一页
+ */
+void ApiManager::fetchSyncPage(int syncId)
+{
+    const int pageSize = 500;
+    const SyncState &state = m_syncs[syncId];
+    
+    QString endpoint = QString("%1?skip=%2&limit=%3").arg(state.path).arg(state.skip).arg(pageSize);
+    if (state.delta) {
+        endpoint += "&updated_since=" + QString::fromLatin1(QUrl::toPercentEncoding(state.since));
+    }
+    
+    // 同步结果只用于表格显示，按表格列投影；明细在打开编辑器时再加载
+    if (state.path == "/users/") {
+        endpoint += projectionQuery(UserTableFields, true);
     } else {
-        qDebug() << "[DEBUG] No reply object found in onNetworkError";
+        endpoint += projectionQuery(QStringList(), false);
     }
+    
+    QString requestType = (state.path == "/users/") ? "user_sync" : "role_sync";
+    sendRequest("GET", endpoint, requestType, QJsonObject(), state.priority)->then(this, [this, syncId](ApiReply *reply) {
+        handleSyncPage(syncId, reply);
+    });
 }
 
 /**
- * 处理响应数据
+ * 处理同步页响应
  */
-void ApiManager::handleResponse(QNetworkReply *reply, const QString &requestType)
+void ApiManager::handleSyncPage(int syncId, ApiReply *reply)
 {
-    QByteArray responseData = reply->readAll();
+    const int pageSize = 500;
+    auto it = m_syncs.find(syncId);
+    if (it == m_syncs.end()) {
+        return;
+    }
     
-    // 检查HTTP状态码
-    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (!it->reply || it->reply->isCanceled()) {
+        m_syncs.erase(it);
+        return;
+    }
     
-    // 检查Token是否过期（401状态码）
-    if (statusCode == 401) {
-        qDebug() << "[DEBUG] Token expired (401), clearing auth token and emitting tokenExpired signal";
-        m_authToken.clear();
-        emit tokenExpired();
+    if (!reply->isSuccess()) {
+        if (it->delta && (reply->statusCode() == 400 || reply->statusCode() == 422)) {
+            // 服务端拒绝updated_since参数，改为全量同步
+            qDebug() << "[DEBUG] Delta sync rejected for" << it->path << "- falling back to full resync";
+            it->delta = false;
+            it->since.clear();
+            it->skip = 0;
+            it->users.clear();
+            it->roles.clear();
+            it->deletedIds.clear();
+            it->maxUpdatedAt.clear();
+            fetchSyncPage(syncId);
+            return;
+        }
+        
+        ApiResult result = reply->result();
+        QPointer<ApiReply> apiReply = it->reply;
+        m_syncs.erase(it);
+        if (apiReply) {
+            apiReply->resolve(result);
+        }
         return;
     }
     
-    // 解析JSON响应
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
+    SyncPage page = reply->value<SyncPage>();
+    if (it->delta && !page.hasDeletedIds) {
+        // 服务端忽略了增量参数，返回的是完整列表，按全量同步处理
+        qDebug() << "[DEBUG] Server ignored updated_since for" << it->path << "- treating as full resync";
+        it->delta = false;
+        it->since.clear();
+    }
+    
+    int pageItems = page.users.size() + page.roles.size();
+    it->users.append(page.users);
+    it->roles.append(page.roles);
+    it->deletedIds.append(page.deletedIds);
+    it->maxUpdatedAt = EntityStore::laterWatermark(it->maxUpdatedAt, page.maxUpdatedAt);
     
-    if (parseError.error != QJsonParseError::NoError) {
-        emit networkError("JSON解析错误: " + parseError.errorString());
+    if (pageItems >= pageSize) {
+        it->skip += pageItems;
+        fetchSyncPage(syncId);
         return;
     }
     
-    QJsonObject response = doc.object();
-    bool success = (statusCode >= 200 && statusCode < 300);
+    finishSync(syncId);
+}
+
+/**
+ * 全部页面到齐后合并到本地实体存储
+ */
+void ApiManager::finishSync(int syncId)
+{
+    SyncState state = m_syncs.take(syncId);
     
-    if (requestType == "login") {
-        qDebug() << "[DEBUG] Processing login response";
-        qDebug() << "[DEBUG] Raw response data:" << responseData;
-        qDebug() << "[DEBUG] HTTP status code:" << statusCode;
-        qDebug() << "[DEBUG] Success flag:" << success;
-        qDebug() << "[DEBUG] JSON response object:" << response;
-        
-        QString message = response["message"].toString();
-        QString token = response["access_token"].toString();
+    ApiResult result;
+    result.success = true;
+    result.statusCode = 200;
+    
+    // 时间戳由服务端生成并统一为ISO 8601格式，可直接按字符串比较，不受本地时钟影响
+    if (state.path == "/users/") {
+        QString watermark = state.delta ? EntityStore::laterWatermark(m_entityStore->usersWatermark(), state.maxUpdatedAt)
+                                        : state.maxUpdatedAt;
+        if (state.delta) {
+            m_entityStore->mergeUsers(state.users, state.deletedIds, watermark);
+        } else {
+            m_entityStore->setUsers(state.users, watermark);
+        }
+        result.value = QVariant::fromValue(m_entityStore->users());
+    } else {
+        QString watermark = state.delta ? EntityStore::laterWatermark(m_entityStore->rolesWatermark(), state.maxUpdatedAt)
+                                        : state.maxUpdatedAt;
+        if (state.delta) {
+            m_entityStore->mergeRoles(state.roles, state.deletedIds, watermark);
+        } else {
+            m_entityStore->setRoles(state.roles, watermark);
+        }
+        result.value = QVariant::fromValue(m_entityStore->roles());
+    }
+    
+    qDebug() << "[DEBUG] Sync finished for" << state.path << (state.delta ? "(delta)" : "(full)")
+             << "records:" << state.users.size() + state.roles.size() << "deleted:" << state.deletedIds.size();
+    
+    if (state.reply) {
+        state.reply->resolve(result);
+    }
+}
+
+/**
+ * 批量提交操作
+ * 不限流时批次内的请求一次性全部发出（允许HTTP管线化），由QNetworkAccessManager
+ * 在每主机连接上并发执行；大批量操作通过并发与速率上限排队发出，
+ * 全部完成后句柄只完成一次
+ */
+ApiReply *ApiManager::submitBatch(const QList<BatchOperation> &operations, Priority priority,
+                                  int maxConcurrent, int maxPerSecond)
+{
+    ApiReply *apiReply = new ApiReply(this);
+    
+    if (operations.isEmpty()) {
+        // 空批次直接完成，保持调用方处理流程一致
+        QMetaObject::invokeMethod(apiReply, [apiReply]() {
+            ApiResult result;
+            result.success = true;
+            result.value = QVariant::fromValue(BatchResult());
+            apiReply->resolve(result);
+        }, Qt::QueuedConnection);
+        return apiReply;
+    }
+    
+    int batchId = m_nextBatchId++;
+    
+    BatchState state;
+    state.reply = apiReply;
+    state.operations = operations;
+    state.priority = priority;
+    state.maxConcurrent = maxConcurrent;
+    state.intervalMs = maxPerSecond > 0 ? 1000 / maxPerSecond : 0;
+    m_batches.insert(batchId, state);
+    
+    qDebug() << "[DEBUG] submitBatch - batch" << batchId << "operations:" << operations.size()
+             << "priority:" << (priority == Interactive ? "interactive" : "background")
+             << "maxConcurrent:" << maxConcurrent << "maxPerSecond:" << maxPerSecond;
+    
+    // 取消时停止发出排队的操作，在途请求完成后结束批次
+    connect(apiReply, &ApiReply::canceled, this, [this, batchId]() {
+        auto it = m_batches.find(batchId);
+        if (it == m_batches.end()) {
+            return;
+        }
+        it->operations = it->operations.mid(0, it->nextIndex);
+        // 等待重发的操作不再发出，按失败计入
+        for (int index : std::as_const(it->requeued)) {
+            it->failed.append(it->operations[index]);
+            it->errors.append("操作已取消");
+        }
+        it->completed += it->requeued.size();
+        it->requeued.clear();
+        if (it->completed == it->nextIndex) {
+            m_batches.erase(it);
+        }
+    });
+    
+    pumpBatch(batchId);
+    
+    return apiReply;
+}
+
+/**
+ * 按并发与速率限制发出批次中排队的操作
+ */
+void ApiManager::pumpBatch(int batchId)
+{
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    while (!it->requeued.isEmpty() || it->nextIndex < it->operations.size()) {
+        if (it->maxConcurrent > 0 && it->inFlight >= it->maxConcurrent) {
+            // 等待在途请求完成后再继续
+            return;
+        }
         
-        qDebug() << "[DEBUG] Extracted message:" << message;
-        qDebug() << "[DEBUG] Extracted token:" << token;
+        if (it->priority == Background && m_backpressured) {
+            // 后台队列已满，等背压解除后再继续提交
+            return;
+        }
         
-        // 根据API规范，登录成功时应该返回Token对象
-        // 检查是否有token_type字段来确认这是正确的登录响应
-        QString tokenType = response["token_type"].toString();
-        qDebug() << "[DEBUG] Token type:" << tokenType;
+        if (it->intervalMs > 0) {
+            qint64 now = QDateTime::currentMSecsSinceEpoch();
+            if (now < it->nextDispatchAt) {
+                if (!it->pumpScheduled) {
+                    it->pumpScheduled = true;
+                    QTimer::singleShot(int(it->nextDispatchAt - now), this, [this, batchId]() {
+                        auto pending = m_batches.find(batchId);
+                        if (pending != m_batches.end()) {
+                            pending->pumpScheduled = false;
+                            pumpBatch(batchId);
+                        }
+                    });
+                }
+                return;
+            }
+            it->nextDispatchAt = qMax(now, it->nextDispatchAt) + it->intervalMs;
+        }
         
-        if (tokenType.isEmpty() && success) {
-            // 如果没有token_type但有access_token，仍然认为是有效响应
-            tokenType = "bearer";
-            qDebug() << "[DEBUG] Using default token type: bearer";
+        it->inFlight++;
+        if (!it->requeued.isEmpty()) {
+            // 批量接口不可用或单项需要重试的操作逐个发出
+            sendBatchOperation(batchId, it->requeued.takeFirst());
+            continue;
         }
         
-        // 如果没有message字段，使用默认消息
-        if (message.isEmpty()) {
-            message = success ? "登录成功" : "登录失败";
-            qDebug() << "[DEBUG] Using default message:" << message;
+        int index = it->nextIndex;
+        int remaining = it->operations.size() - index;
+        if (m_batchEnvelope && !m_batchEndpointMissing && remaining > 1) {
+            // 剩余多个操作时打包为一个请求，并发与速率限制按请求计算
+            int count = qMin(m_batchSize, remaining);
+            it->nextIndex += count;
+            sendBatchEnvelope(batchId, index, count);
+        } else {
+            it->nextIndex++;
+            sendBatchOperation(batchId, index);
+        }
+    }
+}
+
+/**
+ * 批量操作对应的单个请求
+ */
+ApiManager::BatchRequest ApiManager::batchRequestFor(const BatchOperation &operation)
+{
+    BatchRequest request;
+    switch (operation.type) {
+    case BatchOperation::AssignRole:
+        request.endpoint = QString("/roles/users/%1/assign/%2").arg(operation.userId).arg(operation.roleId);
+        request.requestType = "assign_role";
+        request.method = "POST";
+        break;
+    case BatchOperation::RemoveRole:
+        request.endpoint = QString("/roles/users/%1/remove/%2").arg(operation.userId).arg(operation.roleId);
+        request.requestType = "remove_role";
+        request.method = "DELETE";
+        break;
+    case BatchOperation::SetUserActive:
+        request.endpoint = QString("/users/%1").arg(operation.userId);
+        request.requestType = "update_user";
+        request.method = "PUT";
+        request.data["is_active"] = operation.isActive;
+        break;
+    }
+    return request;
+}
+
+/**
+ * 发出批次中的单个操作
+ */
+void ApiManager::sendBatchOperation(int batchId, int index)
+{
+    BatchRequest batchRequest = batchRequestFor(m_batches[batchId].operations[index]);
+    QByteArray method = batchRequest.method;
+    QByteArray body;
+    if (method != "DELETE") {
+        body = QJsonDocument(batchRequest.data).toJson(QJsonDocument::Compact);
+    }
+    
+    QNetworkRequest request = buildRequest(batchRequest.endpoint, batchRequest.requestType);
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    
+    if (!m_batches[batchId].attempts.contains(index)) {
+        depositRetryBudget();
+    }
+    
+    // 批量操作按提交时指定的队列发出，大批量后台操作不阻塞用户操作触发的请求
+    scheduleDispatch(m_batches[batchId].priority, [this, request, method, body, batchId, index]() -> NetworkCall * {
+        if (!m_batches.contains(batchId)) {
+            return nullptr;
         }
         
-        if (success && !token.isEmpty()) {
-            m_authToken = token;
-            qDebug() << "[DEBUG] Token saved to m_authToken:" << m_authToken;
+        NetworkCall *reply = dispatchRequest(method, request, body);
+        
+        // 批次内各请求的结果统一在批次完成时汇总到批次句柄
+        connect(reply, &NetworkCall::finished, this, [this, reply, batchId, index, method]() {
+            handleBatchReply(reply, batchId, index, method);
+        });
+        return reply;
+    });
+}
+
+/**
+ * 将批次中的一段操作打包为一个批量请求发出
+ * 请求体为{"operations": [{"id", "method", "path", "body"}]}，id为操作在批次中的序号，
+ * path与单个请求的端点相同（相对于API基础地址）
+ */
+void ApiManager::sendBatchEnvelope(int batchId, int index, int count)
+{
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    QJsonArray operations;
+    for (int i = index; i < index + count; ++i) {
+        BatchRequest batchRequest = batchRequestFor(it->operations[i]);
+        QJsonObject operation;
+        operation["id"] = i;
+        operation["method"] = QString::fromLatin1(batchRequest.method);
+        operation["path"] = batchRequest.endpoint;
+        if (batchRequest.method != "DELETE") {
+            operation["body"] = batchRequest.data;
+        }
+        operations.append(operation);
+    }
+    QJsonObject envelope;
+    envelope["operations"] = operations;
+    
+    QNetworkRequest request = buildRequest("/batch", "batch");
+    QByteArray body = QJsonDocument(envelope).toJson(QJsonDocument::Compact);
+    bool compressed = compressBody(request, body);
+    
+    if (!it->attempts.contains(index)) {
+        depositRetryBudget();
+    }
+    
+    scheduleDispatch(it->priority, [this, request, body, batchId, index, count, compressed]() -> NetworkCall * {
+        if (!m_batches.contains(batchId)) {
+            return nullptr;
         }
         
-        qDebug() << "[DEBUG] About to emit loginResult with:";
-        qDebug() << "[DEBUG]   success:" << success;
-        qDebug() << "[DEBUG]   message:" << message;
-        qDebug() << "[DEBUG]   token:" << token;
+        NetworkCall *reply = dispatchRequest("POST", request, body);
+        connect(reply, &NetworkCall::finished, this, [this, reply, batchId, index, count, compressed]() {
+            handleBatchEnvelopeReply(reply, batchId, index, count, compressed);
+        });
+        return reply;
+    });
+}
+
+/**
+ * 处理批次中单个操作的响应
+ */
+void ApiManager::handleBatchReply(NetworkCall *reply, int batchId, int index, const QByteArray &method)
+{
+    reply->deleteLater();
+    
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    if (isConnectionFailure(reply)) {
+        m_endpoints->reportFailure(reply->url());
+    }
+    
+    // 临时故障按退避时间重新发出该操作，批次取消后不再重试
+    if (it->reply && !it->reply->isCanceled()) {
+        int attempt = it->attempts.value(index);
+        int delay = retryDelay(reply, method, reply->request().attribute(QNetworkRequest::User).toString(), attempt);
+        if (delay >= 0) {
+            it->attempts[index] = attempt + 1;
+            QTimer::singleShot(delay, this, [this, batchId, index]() {
+                if (m_batches.contains(batchId)) {
+                    sendBatchOperation(batchId, index);
+                }
+            });
+            return;
+        }
+    }
+    
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 401) {
+        if (canRefreshToken()) {
+            // 令牌在批量操作途中过期，刷新后重发该操作，批量任务不中断
+            awaitTokenRefresh(reply->request().rawHeader("Authorization"), [this, batchId, index](bool refreshed) {
+                if (!m_batches.contains(batchId)) {
+                    return;
+                }
+                if (refreshed) {
+                    sendBatchOperation(batchId, index);
+                } else {
+                    finishBatchOperation(batchId, index, false, "登录已过期");
+                }
+            });
+            return;
+        }
         
-        emit loginResult(success, message, token);
-        qDebug() << "[DEBUG] loginResult signal emitted";
+        qDebug() << "[DEBUG] Token expired (401) during batch" << batchId;
+        if (!m_authToken.isEmpty()) {
+            setAuthToken(QString());
+            emit tokenExpired();
+        }
+        if (!m_batches.contains(batchId)) {
+            return;
+        }
     }
-    else if (requestType == "logout") {
-        QString message = success ? "退出登录成功" : "退出登录失败";
-        if (success) {
-            m_authToken.clear();
+    
+    if (statusCode >= 200 && statusCode < 300) {
+        invalidateAfterMutation(reply->request().attribute(QNetworkRequest::User).toString());
+        finishBatchOperation(batchId, index, true, QString());
+    } else {
+        QString error = QJsonDocument::fromJson(reply->body()).object()["detail"].toString();
+        if (error.isEmpty()) {
+            error = reply->error() != QNetworkReply::NoError
+                    ? reply->errorString()
+                    : QString("HTTP %1").arg(statusCode);
         }
-        emit logoutResult(success, message);
+        finishBatchOperation(batchId, index, false, error);
     }
-    else if (requestType == "register") {
-        QString message = response["message"].toString();
-        if (success) {
-            UserInfo user = parseUserInfo(response);
-            emit registerResult(success, message, user);
-        } else {
-            emit registerResult(success, message, UserInfo());
+}
+
+/**
+ * 处理批量请求的响应
+ * 服务端没有批量接口时本段操作改为逐个发出；整体的临时故障与401按单个请求的方式重试，
+ * 其他错误使本段操作全部失败
+ */
+void ApiManager::handleBatchEnvelopeReply(NetworkCall *reply, int batchId, int index, int count, bool compressed)
+{
+    reply->deleteLater();
+    
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    if (isConnectionFailure(reply)) {
+        m_endpoints->reportFailure(reply->url());
+    }
+    
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode == 404 || statusCode == 405 || statusCode == 501) {
+        // 本段操作放回批次队列，逐个发出时同样受并发与速率限制
+        qDebug() << "[DEBUG] Batch endpoint not available (HTTP" << statusCode << "), sending operations individually";
+        m_batchEndpointMissing = true;
+        if (!it->reply || it->reply->isCanceled()) {
+            finishBatchEnvelope(batchId, index, count, QJsonArray(), "操作已取消");
+            return;
+        }
+        it->inFlight--;
+        for (int i = index; i < index + count; ++i) {
+            it->requeued.append(i);
         }
+        pumpBatch(batchId);
+        return;
     }
-    else if (requestType == "current_user") {
-        if (success) {
-            UserInfo user = parseUserInfo(response);
-            emit currentUserInfoResult(true, user, "");
+    
+    if (statusCode == 415 && compressed) {
+        qDebug() << "[DEBUG] Compressed batch body rejected, resending uncompressed";
+        m_compressionRejected = true;
+        sendBatchEnvelope(batchId, index, count);
+        return;
+    }
+    
+    if (it->reply && !it->reply->isCanceled()) {
+        int attempt = it->attempts.value(index);
+        int delay = retryDelay(reply, "POST", "batch", attempt);
+        if (delay >= 0) {
+            it->attempts[index] = attempt + 1;
+            QTimer::singleShot(delay, this, [this, batchId, index, count]() {
+                if (m_batches.contains(batchId)) {
+                    sendBatchEnvelope(batchId, index, count);
+                }
+            });
+            return;
+        }
+    }
+    
+    if (statusCode == 401) {
+        if (canRefreshToken()) {
+            awaitTokenRefresh(reply->request().rawHeader("Authorization"), [this, batchId, index, count](bool refreshed) {
+                if (!m_batches.contains(batchId)) {
+                    return;
+                }
+                if (refreshed) {
+                    sendBatchEnvelope(batchId, index, count);
+                } else {
+                    finishBatchEnvelope(batchId, index, count, QJsonArray(), "登录已过期");
+                }
+            });
+            return;
+        }
+        
+        qDebug() << "[DEBUG] Token expired (401) during batch" << batchId;
+        if (!m_authToken.isEmpty()) {
+            setAuthToken(QString());
+            emit tokenExpired();
+        }
+        if (!m_batches.contains(batchId)) {
+            return;
+        }
+    }
+    
+    QJsonObject response = QJsonDocument::fromJson(reply->body()).object();
+    if (statusCode >= 200 && statusCode < 300) {
+        finishBatchEnvelope(batchId, index, count, response["results"].toArray(), QString());
+        return;
+    }
+    
+    QString error = response["detail"].toString();
+    if (error.isEmpty()) {
+        error = reply->error() != QNetworkReply::NoError
+                ? reply->errorString()
+                : QString("HTTP %1").arg(statusCode);
+    }
+    finishBatchEnvelope(batchId, index, count, QJsonArray(), error);
+}
+
+/**
+ * 按操作拆分批量响应
+ * 响应体为{"results": [{"id", "status", "body"}]}，按id对应操作（缺少id时按顺序对应）；
+ * 单个操作的临时故障（429/502/503/504）放回批次队列单独重发
+ */
+void ApiManager::finishBatchEnvelope(int batchId, int index, int count, const QJsonArray &results, const QString &error)
+{
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    QHash<int, QJsonObject> resultsById;
+    for (int i = 0; i < results.size(); ++i) {
+        QJsonObject result = results[i].toObject();
+        resultsById.insert(result.contains("id") ? result["id"].toInt() : index + i, result);
+    }
+    
+    bool canceled = !it->reply || it->reply->isCanceled();
+    QList<int> retries;
+    QList<int> succeeded;
+    QList<QPair<int, QString>> failed;
+    QSet<QString> mutatedTypes;
+    for (int i = index; i < index + count; ++i) {
+        if (!error.isEmpty()) {
+            failed.append({i, error});
+            continue;
+        }
+        
+        auto result = resultsById.constFind(i);
+        if (result == resultsById.constEnd()) {
+            failed.append({i, "批量响应中缺少该操作的结果"});
+            continue;
+        }
+        
+        int status = result->value("status").toInt();
+        if (status >= 200 && status < 300) {
+            succeeded.append(i);
+            mutatedTypes.insert(batchRequestFor(it->operations[i]).requestType);
+        } else if (!canceled && (status == 429 || status == 502 || status == 503 || status == 504)) {
+            retries.append(i);
         } else {
-            emit currentUserInfoResult(false, UserInfo(), response["detail"].toString());
+            QString detail = result->value("body").toObject()["detail"].toString();
+            failed.append({i, detail.isEmpty() ? QString("HTTP %1").arg(status) : detail});
         }
     }
-    else if (requestType == "user_list") {
-        qDebug() << "[DEBUG] Processing user_list response";
-        qDebug() << "[DEBUG] Raw response data:" << responseData;
-        qDebug() << "[DEBUG] HTTP status code:" << statusCode;
-        qDebug() << "[DEBUG] Success flag:" << success;
-        qDebug() << "[DEBUG] JSON response object:" << response;
+    
+    // 批量请求整体释放一个在途名额，重发的操作由pumpBatch按并发与速率限制发出
+    it->inFlight--;
+    it->requeued.append(retries);
+    
+    for (const QString &requestType : std::as_const(mutatedTypes)) {
+        invalidateAfterMutation(requestType);
+    }
+    
+    // 最后一项完成时批次结束并被移除
+    for (int i : std::as_const(succeeded)) {
+        finishBatchOperation(batchId, i, true, QString(), false);
+    }
+    for (const QPair<int, QString> &failure : std::as_const(failed)) {
+        finishBatchOperation(batchId, failure.first, false, failure.second, false);
+    }
+    if (!retries.isEmpty()) {
+        pumpBatch(batchId);
+    }
+}
+
+/**
+ * 记录批量操作中一项的结果，全部完成后完成批次句柄
+ */
+void ApiManager::finishBatchOperation(int batchId, int index, bool success, const QString &error, bool releaseRequest)
+{
+    auto it = m_batches.find(batchId);
+    if (it == m_batches.end()) {
+        return;
+    }
+    
+    BatchState &state = it.value();
+    if (!success) {
+        state.failed.append(state.operations[index]);
+        state.errors.append(error);
+    }
+    
+    state.completed++;
+    if (releaseRequest) {
+        state.inFlight--;
+    }
+    int completed = state.completed;
+    int total = state.operations.size();
+    QPointer<ApiReply> apiReply = state.reply;
+    
+    if (completed == total) {
+        BatchResult batchResult;
+        batchResult.failed = state.failed;
+        batchResult.errors = state.errors;
+        m_batches.erase(it);
+        qDebug() << "[DEBUG] Batch" << batchId << "finished, failed:" << batchResult.failed.size();
         
-        if (success) {
-            // 检查响应是否是数组格式（直接返回用户列表）还是对象格式（包含items字段）
-            QJsonArray usersArray;
-            
-            // 重新解析响应数据，因为可能是数组而不是对象
-            QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
-            
-            if (parseError.error == QJsonParseError::NoError) {
-                if (doc.isArray()) {
-                    // 直接返回的是用户数组
-                    usersArray = doc.array();
-                    qDebug() << "[DEBUG] Parsed as array, items count:" << usersArray.size();
-                } else if (doc.isObject()) {
-                    QJsonObject obj = doc.object();
-                    if (obj.contains("items")) {
-                        // 标准格式：包含items字段的对象
-                        usersArray = obj["items"].toArray();
-                        qDebug() << "[DEBUG] Parsed as object with items, items count:" << usersArray.size();
-                    }
+        if (apiReply) {
+            ApiResult result;
+            result.success = batchResult.failed.isEmpty();
+            result.value = QVariant::fromValue(batchResult);
+            result.error = batchResult.errors.value(0);
+            apiReply->setProgress(completed, total);
+            apiReply->resolve(result);
+        }
+    } else {
+        // 先补发排队操作再通知进度，回调中提交新批次不会影响本批次状态
+        pumpBatch(batchId);
+        if (apiReply) {
+            apiReply->setProgress(completed, total);
+        }
+    }
+}
+
+/**
+ * 处理响应数据，解码一次后送达所有挂在该请求上的句柄
+ */
+void ApiManager::handleResponse(int requestId, NetworkCall *reply)
+{
+    reply->deleteLater();
+    
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end() || it->reply != reply) {
+        return;
+    }
+    it->reply = nullptr;
+    
+    if (reply->error() == QNetworkReply::OperationCanceledError && reply->timeoutKind() == NetworkResponse::NoTimeout) {
+        // 请求已被调用方取消
+        takePending(requestId);
+        return;
+    }
+    
+    if (!it->plainBody.isEmpty()
+        && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 415) {
+        // 服务端不接受压缩的请求体，改为原文重发，此后对该服务器不再压缩
+        qDebug() << "[DEBUG] handleResponse - compressed body rejected, resending uncompressed:" << reply->url().toString();
+        m_compressionRejected = true;
+        it->body = it->plainBody;
+        it->plainBody.clear();
+        it->request.setRawHeader("Content-Encoding", QByteArray());
+        dispatchPending(requestId);
+        return;
+    }
+    
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 401 && it->requestType != "login" && it->requestType != "refresh_token" && canRefreshToken()) {
+        // 令牌在请求途中过期，挂起等待刷新后用新令牌重发
+        awaitTokenRefresh(it->request.rawHeader("Authorization"), [this, requestId](bool refreshed) {
+            auto pending = m_pending.find(requestId);
+            if (pending == m_pending.end()) {
+                return;
+            }
+            if (refreshed) {
+                pending->request.setRawHeader("Authorization", ("Bearer " + m_authToken).toUtf8());
+                dispatchPending(requestId);
+                return;
+            }
+            PendingRequest expired = takePending(requestId);
+            ApiResult result = decodeResponse(401, QByteArray(), QByteArray(), expired.requestType, QString());
+            for (const QPointer<ApiReply> &apiReply : expired.subscribers) {
+                if (apiReply) {
+                    apiReply->resolve(result);
                 }
             }
-            
-            QList<UserInfo> users = parseUserList(usersArray);
-            qDebug() << "[DEBUG] Parsed users count:" << users.size();
-            emit userListResult(true, users, "");
-        } else {
-            emit userListResult(false, QList<UserInfo>(), response["detail"].toString());
+        });
+        return;
+    }
+    
+    if ((status == 400 || status == 422) && it->method == "GET") {
+        QUrl url = it->request.url();
+        QUrlQuery query(url);
+        if (query.hasQueryItem("fields") || query.hasQueryItem("include_permissions")) {
+            // 服务端不支持字段投影，去掉投影参数重发，此后对该服务器不再使用
+            qDebug() << "[DEBUG] handleResponse - field projection rejected, resending without it:" << url.toString();
+            m_projectionRejected = true;
+            query.removeAllQueryItems("fields");
+            query.removeAllQueryItems("include_permissions");
+            url.setQuery(query);
+            it->request.setUrl(url);
+            dispatchPending(requestId);
+            return;
         }
     }
-    else if (requestType == "user_info") {
-        if (success) {
-            UserInfo user = parseUserInfo(response);
-            emit userInfoResult(true, user, "");
-        } else {
-            emit userInfoResult(false, UserInfo(), response["detail"].toString());
+    
+    // 节点不可达时切换到其他健康节点，随后的重试发往新节点
+    if (isConnectionFailure(reply)) {
+        m_endpoints->reportFailure(reply->url());
+    }
+    
+    // 临时故障按退避时间重新发出，等待期间相同的GET仍会合并到本请求
+    int delay = retryDelay(reply, it->method, it->requestType, it->attempt);
+    if (delay >= 0) {
+        it->attempt++;
+        QTimer::singleShot(delay, this, [this, requestId]() {
+            dispatchPending(requestId);
+        });
+        return;
+    }
+    
+    // 条件请求返回304时缓存条目已被淘汰或失效，去掉验证器重新获取完整响应
+    if (status == 304 && !it->cacheKey.isEmpty()
+        && (it->request.hasRawHeader("If-None-Match") || it->request.hasRawHeader("If-Modified-Since"))) {
+        ResponseCache::Entry cached;
+        if (!m_responseCache.lookup(it->cacheKey, &cached)) {
+            qDebug() << "[DEBUG] handleResponse - 304 for evicted cache entry, refetching:" << reply->url().toString();
+            it->request.setRawHeader("If-None-Match", QByteArray());
+            it->request.setRawHeader("If-Modified-Since", QByteArray());
+            dispatchPending(requestId);
+            return;
         }
     }
-    else if (requestType == "update_user") {
-        if (success) {
-            UserInfo user = parseUserInfo(response);
-            emit updateUserResult(true, user, "");
-        } else {
-            emit updateUserResult(false, UserInfo(), response["detail"].toString());
+    
+    PendingRequest pending = takePending(requestId);
+    
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray responseData = reply->body();
+    QByteArray contentType = reply->rawHeader("Content-Type");
+    bool fromCache = false;
+    
+    if (!pending.cacheKey.isEmpty()) {
+        if (statusCode == 304) {
+            // 内容未变化，复用缓存内容并延长有效期
+            ResponseCache::Entry entry;
+            if (m_responseCache.lookup(pending.cacheKey, &entry)) {
+                qDebug() << "[DEBUG] handleResponse - not modified:" << reply->url().toString();
+                m_responseCache.refresh(pending.cacheKey);
+                statusCode = 200;
+                responseData = entry.body;
+                contentType = entry.contentType;
+                fromCache = true;
+            }
+        } else if (statusCode >= 200 && statusCode < 300) {
+            ResponseCache::Entry entry;
+            entry.url = reply->url();
+            entry.path = pending.path;
+            entry.body = responseData;
+            entry.contentType = contentType;
+            entry.etag = reply->rawHeader("ETag");
+            entry.lastModified = reply->rawHeader("Last-Modified");
+            m_responseCache.store(pending.cacheKey, entry);
         }
     }
-    else if (requestType == "role_list") {
-        qDebug() << "[DEBUG] Processing role_list response";
-        qDebug() << "[DEBUG] Raw response data:" << responseData;
-        qDebug() << "[DEBUG] HTTP status code:" << statusCode;
-        qDebug() << "[DEBUG] Success flag:" << success;
-        qDebug() << "[DEBUG] JSON response object:" << response;
+    
+    // 网络响应已在网络线程中解码，复用缓存内容时在此解码
+    ApiResult result;
+    if (!fromCache && reply->decoded().canConvert<ApiResult>()) {
+        result = reply->decoded().value<ApiResult>();
+        applySessionResult(pending.requestType, result);
+    } else {
+        result = decodeResponse(statusCode, responseData, contentType, pending.requestType, reply->errorString());
+    }
+    if (result.success) {
+        invalidateAfterMutation(pending.requestType);
+        updateEntityStore(pending.requestType, reply->url(), result);
+    }
+    for (const QPointer<ApiReply> &apiReply : pending.subscribers) {
+        if (apiReply) {
+            apiReply->resolve(result);
+        }
+    }
+}
+
+/**
+ * 从列表响应中取出数组（兼容直接返回数组和包含items字段的对象）
+ */
+QJsonArray ApiManager::extractItems(const QJsonDocument &doc)
+{
+    if (doc.isArray()) {
+        return doc.array();
+    }
+    return doc.object()["items"].toArray();
+}
+
+/**
+ * 按请求类型解码响应并更新会话状态
+ */
+ApiResult ApiManager::decodeResponse(int statusCode, const QByteArray &responseData, const QByteArray &contentType,
+                                     const QString &requestType, const QString &errorString)
+{
+    ApiResult result = parseResponse(statusCode, responseData, contentType, requestType, errorString);
+    applySessionResult(requestType, result);
+    return result;
+}
+
+/**
+ * 按解码结果更新会话状态
+ */
+void ApiManager::applySessionResult(const QString &requestType, const ApiResult &result)
+{
+    // 检查Token是否过期（401状态码），能刷新的请求在handleResponse中已挂起等待刷新
+    if (result.statusCode == 401 && requestType != "login" && requestType != "refresh_token") {
+        if (!m_authToken.isEmpty()) {
+            qDebug() << "[DEBUG] Token expired (401), clearing auth token and emitting tokenExpired signal";
+            setAuthToken(QString());
+            emit tokenExpired();
+        }
+        return;
+    }
+    
+    if (!result.success) {
+        return;
+    }
+    if (requestType == "login" || requestType == "refresh_token") {
+        QString token = result.value.toString();
+        if (!token.isEmpty()) {
+            setAuthToken(token);
+        }
+    } else if (requestType == "logout") {
+        setAuthToken(QString());
+    }
+}
+
+/**
+ * 按请求类型解码响应
+ */
+ApiResult ApiManager::parseResponse(int statusCode, const QByteArray &responseData, const QByteArray &contentType,
+                                    const QString &requestType, const QString &errorString)
+{
+    ApiResult result;
+    result.statusCode = statusCode;
+    
+    // 没有收到HTTP响应，属于网络错误
+    if (statusCode == 0) {
+        qDebug() << "[DEBUG] Network error:" << errorString << "type:" << requestType;
+        result.error = errorString;
+        return result;
+    }
+    
+    // Token过期（401状态码），会话状态由applySessionResult更新
+    if (statusCode == 401 && requestType != "login" && requestType != "refresh_token") {
+        result.error = "登录已过期";
+        return result;
+    }
+    
+    bool success = (statusCode >= 200 && statusCode < 300);
+    
+    // CBOR列表响应与同步页在下面按类型流式解码，其余CBOR响应（错误信息等）转换为JSON处理
+    bool cbor = CborDecoder::isCbor(contentType);
+    bool cborList = cbor && success
+                    && (requestType == "user_list" || requestType == "role_list" || requestType == "permission_list"
+                        || requestType == "user_sync" || requestType == "role_sync");
+    
+    // 解析JSON响应（DELETE等请求可能返回空响应体）
+    QJsonDocument doc;
+    if (cbor && !cborList && !responseData.isEmpty()) {
+        QString cborError;
+        if (!CborDecoder::toJsonDocument(responseData, &doc, &cborError)) {
+            result.error = "CBOR解析错误: " + cborError;
+            return result;
+        }
+    } else if (!cbor && !responseData.trimmed().isEmpty()) {
+        QJsonParseError parseError;
+        doc = QJsonDocument::fromJson(responseData, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            result.error = "JSON解析错误: " + parseError.errorString();
+            return result;
+        }
+    }
+    
+    QJsonObject response = doc.object();
+    result.success = success;
+    if (!success) {
+        result.error = response["detail"].toString();
+        if (result.error.isEmpty()) {
+            result.error = response["message"].toString();
+        }
+        if (result.error.isEmpty()) {
+            result.error = errorString;
+        }
+    }
+    
+    if (requestType == "login" || requestType == "refresh_token") {
+        qDebug() << "[DEBUG] Processing" << requestType << "response, HTTP status code:" << statusCode;
         
+        QString token = response["access_token"].toString();
+        result.message = response["message"].toString();
+        
+        // 如果没有message字段，使用默认消息
+        if (result.message.isEmpty()) {
+            result.message = success ? "登录成功" : "登录失败";
+        }
+        
+        result.value = token;
+    }
+    else if (requestType == "logout") {
+        result.message = success ? "退出登录成功" : "退出登录失败";
+    }
+    else if (requestType == "register") {
+        result.message = response["message"].toString();
         if (success) {
-            QJsonArray rolesArray;
-            if (response.contains("items") && response["items"].isArray()) {
-                // 如果响应包含 items 字段
-                rolesArray = response["items"].toArray();
-                qDebug() << "[DEBUG] Role list items array:" << rolesArray;
-            } else if (doc.isArray()) {
-                // 如果响应直接是数组
-                rolesArray = doc.array();
-                qDebug() << "[DEBUG] Role list direct array:" << rolesArray;
-            }
-            
-            qDebug() << "[DEBUG] Role list items count:" << rolesArray.size();
-            QList<RoleInfo> roles = parseRoleList(rolesArray);
-            qDebug() << "[DEBUG] Parsed roles count:" << roles.size();
-            emit roleListResult(true, roles, "");
-        } else {
-            qDebug() << "[DEBUG] Role list request failed";
-            emit roleListResult(false, QList<RoleInfo>(), response["detail"].toString());
+            result.value = QVariant::fromValue(parseUserInfo(response));
         }
     }
-    else if (requestType == "role_info") {
+    else if (requestType == "current_user" || requestType == "session_check" || requestType == "user_info"
+             || requestType == "update_user") {
         if (success) {
-            RoleInfo role = parseRoleInfo(response);
-            emit roleInfoResult(true, role, "");
-        } else {
-            emit roleInfoResult(false, RoleInfo(), response["detail"].toString());
+            result.value = QVariant::fromValue(parseUserInfo(response));
         }
     }
-    else if (requestType == "create_role") {
+    else if (requestType == "user_list") {
         if (success) {
-            RoleInfo role = parseRoleInfo(response);
-            emit createRoleResult(true, role, "");
-        } else {
-            emit createRoleResult(false, RoleInfo(), response["detail"].toString());
+            QList<UserInfo> users;
+            if (!cborList) {
+                users = parseUserList(extractItems(doc));
+            } else if (!CborDecoder::decodeUsers(responseData, &users)) {
+                result.success = false;
+                result.error = "CBOR解析错误";
+                return result;
+            }
+            qDebug() << "[DEBUG] Parsed users count:" << users.size();
+            result.value = QVariant::fromValue(users);
+        }
+    }
+    else if (requestType == "role_list") {
+        if (success) {
+            QList<RoleInfo> roles;
+            if (!cborList) {
+                roles = parseRoleList(extractItems(doc));
+            } else if (!CborDecoder::decodeRoles(responseData, &roles)) {
+                result.success = false;
+                result.error = "CBOR解析错误";
+                return result;
+            }
+            qDebug() << "[DEBUG] Parsed roles count:" << roles.size();
+            result.value = QVariant::fromValue(roles);
         }
     }
-    else if (requestType == "update_role") {
+    else if (requestType == "role_info" || requestType == "create_role" || requestType == "update_role") {
         if (success) {
-            RoleInfo role = parseRoleInfo(response);
-            emit updateRoleResult(true, role, "");
-        } else {
-            emit updateRoleResult(false, RoleInfo(), response["detail"].toString());
+            result.value = QVariant::fromValue(parseRoleInfo(response));
         }
     }
     else if (requestType == "delete_role") {
-        QString message = success ? "删除角色成功" : "";
-        QString error = success ? "" : response["detail"].toString();
-        emit deleteRoleResult(success, message, error);
+        result.message = success ? "删除角色成功" : "";
     }
     else if (requestType == "assign_role") {
-        QString message = success ? "分配角色成功" : "";
-        QString error = success ? "" : response["detail"].toString();
-        emit assignRoleResult(success, message, error);
+        result.message = success ? "分配角色成功" : "";
     }
     else if (requestType == "remove_role") {
-        QString message = success ? "移除角色成功" : "";
-        QString error = success ? "" : response["detail"].toString();
-        emit removeRoleResult(success, message, error);
+        result.message = success ? "移除角色成功" : "";
     }
     else if (requestType == "permission_list") {
         if (success) {
-            QList<PermissionInfo> permissions = parsePermissionList(response["items"].toArray());
-            emit permissionListResult(true, permissions, "");
-        } else {
-            emit permissionListResult(false, QList<PermissionInfo>(), response["detail"].toString());
+            QList<PermissionInfo> permissions;
+            if (!cborList) {
+                permissions = parsePermissionList(extractItems(doc));
+            } else if (!CborDecoder::decodePermissions(responseData, &permissions)) {
+                result.success = false;
+                result.error = "CBOR解析错误";
+                return result;
+            }
+            result.value = QVariant::fromValue(permissions);
+        }
+    }
+    else if (requestType == "user_sync" || requestType == "role_sync") {
+        // 同步页解码为实体后由handleSyncPage按页汇总
+        if (success) {
+            bool users = (requestType == "user_sync");
+            SyncPage page;
+            if (cborList) {
+                bool decoded = users ? CborDecoder::decodeUserSyncPage(responseData, &page)
+                                     : CborDecoder::decodeRoleSyncPage(responseData, &page);
+                if (!decoded) {
+                    result.success = false;
+                    result.error = "CBOR解析错误";
+                    return result;
+                }
+            } else {
+                if (users) {
+                    page.users = parseUserList(extractItems(doc));
+                } else {
+                    page.roles = parseRoleList(extractItems(doc));
+                }
+                QJsonObject object = doc.object();
+                page.hasDeletedIds = object.contains("deleted_ids");
+                for (const QJsonValue &id : object["deleted_ids"].toArray()) {
+                    page.deletedIds.append(id.toInt());
+                }
+            }
+            
+            // 本页的高水位
+            for (const UserInfo &user : std::as_const(page.users)) {
+                page.maxUpdatedAt = EntityStore::laterWatermark(page.maxUpdatedAt, user.updatedAt);
+            }
+            for (const RoleInfo &role : std::as_const(page.roles)) {
+                page.maxUpdatedAt = EntityStore::laterWatermark(page.maxUpdatedAt, role.updatedAt);
+            }
+            result.value = QVariant::fromValue(page);
         }
     }
     else if (requestType == "format") {
-        QString result = response["result"].toString();
+        result.value = response["result"].toString();
         QString error = response["error"].toString();
-        
-        emit formatStringResult(success, result, error);
+        if (!error.isEmpty()) {
+            result.error = error;
+        }
     }
+    
+    return result;
 }
 
-
-
 /**
  * 解析用户信息
  */
@@ -642,6 +2376,7 @@ UserInfo ApiManager::parseUserInfo(const QJsonObject &json)
     user.fullName = json["full_name"].toString();
     user.isActive = json["is_active"].toBool();
     user.createdAt = json["created_at"].toString();
+    user.updatedAt = json["updated_at"].toString();
     user.lastLogin = json["last_login"].toString();
     
     // 解析角色列表
@@ -697,6 +2432,7 @@ RoleInfo ApiManager::parseRoleInfo(const QJsonObject &json)
         permission.action = permObj["action"].toString();
         role.permissions.append(permission);
     }
+    role.permissionCount = json.contains("permissions") ? role.permissions.size() : json["permission_count"].toInt();
     
     return role;
 }
@@ -2,29 +2,36 @@
 #define APIMANAGER_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QString>
+#include <QHash>
+#include <QSet>
+#include <functional>
+#include <QPointer>
+#include "apireply.h"
+#include "networkthread.h"
+#include "responsecache.h"
+#include "tlssessioncache.h"
 
 // 用户信息结构
 struct UserInfo {
-    int id;
+    int id = 0;
     QString username;
     QString email;
     QString fullName;
-    bool isActive;
-    bool isSuperuser;
+    bool isActive = false;
+    bool isSuperuser = false;
     QString createdAt;
+    QString updatedAt;
     QString lastLogin;
     QStringList roles;
 };
 
 // 权限信息结构
 struct PermissionInfo {
-    int id;
+    int id = 0;
     QString name;
     QString displayName;
     QString description;
@@ -34,126 +41,465 @@ struct PermissionInfo {
 
 // 角色信息结构
 struct RoleInfo {
-    int id;
+    int id = 0;
     QString name;
     QString displayName;
     QString description;
-    bool isActive;
+    bool isActive = false;
     QString createdAt;
     QString updatedAt;
     QList<PermissionInfo> permissions;
+    int permissionCount = 0;    // 列表接口不返回权限明细时由permission_count给出
+};
+
+// 批量操作描述（角色分配/移除、用户激活状态等小粒度变更）
+struct BatchOperation {
+    enum Type {
+        AssignRole,
+        RemoveRole,
+        SetUserActive
+    };
+    Type type;
+    int userId;
+    int roleId;
+    bool isActive = true;
 };
 
+// 批量操作结果
+struct BatchResult {
+    QList<BatchOperation> failed;
+    QStringList errors;
+};
+
+// 增量同步的一页（用户页只填users，角色页只填roles）
+struct SyncPage {
+    QList<UserInfo> users;
+    QList<RoleInfo> roles;
+    QList<int> deletedIds;
+    bool hasDeletedIds = false;     // 响应是带deleted_ids的增量对象，而不是完整列表
+    QString maxUpdatedAt;           // 本页记录中最大的updated_at
+};
+
+Q_DECLARE_METATYPE(UserInfo)
+Q_DECLARE_METATYPE(RoleInfo)
+Q_DECLARE_METATYPE(PermissionInfo)
+Q_DECLARE_METATYPE(BatchResult)
+Q_DECLARE_METATYPE(SyncPage)
+
+class EntityStore;
+class EndpointSelector;
+class QTimer;
+
+/**
+ * API管理器
+ * 每个请求方法返回一个ApiReply句柄，结果只送达发起请求的调用方，
+ * 会话级事件（如令牌过期）仍通过信号广播
+ */
 class ApiManager : public QObject
 {
     Q_OBJECT
 
 public:
+    // 请求优先级：交互请求（用户操作触发）优先于后台请求（同步、批量操作）
+    enum Priority {
+        Interactive,
+        Background
+    };
+    
     explicit ApiManager(QObject *parent = nullptr);
     
-    // 设置API基础URL
+    // 设置API基础URL，server/urls配置了其他节点时url为首选节点，实际使用的节点由健康检查决定，
+    // getBaseUrl()返回当前实际使用的节点
     void setBaseUrl(const QString &url);
     
-    // 设置认证令牌
+    // 预先建立到服务器的连接（DNS、TCP与TLS握手），第一个请求无需等待建连
+    void warmUp();
+    
+    // 设置认证令牌，令牌带exp声明时在过期前自动刷新
     void setAuthToken(const QString &token);
     
-    // 认证相关
-    void login(const QString &username, const QString &password);
-    void logout();
-    void registerUser(const QString &username, const QString &email, const QString &password, const QString &fullName = "");
+    // 设置用于静默重新登录的凭据（服务端没有刷新接口时使用，仅保存在内存中）
+    void setCredentials(const QString &username, const QString &password);
     
-    // 用户管理
-    void getCurrentUserInfo();
-    void getUserList(int skip = 0, int limit = 100);
-    void getUserInfo(int userId);
-    void updateUser(int userId, const QString &email = "", const QString &fullName = "", bool isActive = true);
+    // 认证相关（login结果值为令牌QString，register结果值为UserInfo）
+    ApiReply *login(const QString &username, const QString &password);
+    ApiReply *logout();
+    ApiReply *registerUser(const QString &username, const QString &email, const QString &password, const QString &fullName = "");
     
-    // 角色管理
-    void getRoleList(int skip = 0, int limit = 100);
-    void getRoleInfo(int roleId);
-    void createRole(const QString &name, const QString &displayName, const QString &description = "");
-    void updateRole(int roleId, const QString &displayName = "", const QString &description = "", bool isActive = true);
-    void deleteRole(int roleId);
-    void assignRoleToUser(int userId, int roleId);
-    void removeRoleFromUser(int userId, int roleId);
+    // 用户管理（结果值为UserInfo或QList<UserInfo>）
+    // fields为列表只需返回的字段，服务端不支持时返回完整对象
+    ApiReply *getCurrentUserInfo();
     
-    // 权限管理
-    void getPermissionList(int skip = 0, int limit = 100);
+    // 启动时验证保存的令牌（结果值为UserInfo）：不重试、不读缓存，timeoutMs内未完成按失败完成
+    ApiReply *validateSession(int timeoutMs);
+    ApiReply *getUserList(int skip = 0, int limit = 100, const QStringList &fields = QStringList());
+    ApiReply *getUserInfo(int userId);
+    ApiReply *updateUser(int userId, const QString &email = "", const QString &fullName = "", bool isActive = true);
     
-    // 格式化字符串
-    void formatString(const QString &input, const QString &formatType);
+    // 角色管理（结果值为RoleInfo或QList<RoleInfo>）
+    // includePermissions为false时列表只返回权限数量（permissionCount），不含权限明细
+    ApiReply *getRoleList(int skip = 0, int limit = 100, bool includePermissions = true);
+    ApiReply *getRoleInfo(int roleId);
+    ApiReply *createRole(const QString &name, const QString &displayName, const QString &description = "");
+    ApiReply *updateRole(int roleId, const QString &displayName = "", const QString &description = "", bool isActive = true);
+    ApiReply *deleteRole(int roleId);
+    ApiReply *assignRoleToUser(int userId, int roleId);
+    ApiReply *removeRoleFromUser(int userId, int roleId);
+    
+    // 增量同步完整的用户/角色目录到本地实体存储，结果值为合并后的QList<UserInfo>/QList<RoleInfo>
+    // 存储中有高水位时只请求此后变化的记录，服务端不支持增量参数时自动改为全量同步
+    ApiReply *syncUsers(Priority priority = Background);
+    ApiReply *syncRoles(Priority priority = Background);
+    
+    // 批量提交操作，全部完成后句柄完成一次，结果值为BatchResult，期间通过progress信号报告进度
+    // 多个操作打包为POST /batch请求，服务端没有该接口时逐个发出；
+    // priority为批次请求所走的队列，maxConcurrent为同时在途的请求上限，maxPerSecond为每秒发出的请求上限，0表示不限制
+    ApiReply *submitBatch(const QList<BatchOperation> &operations, Priority priority = Background,
+                          int maxConcurrent = 0, int maxPerSecond = 0);
+    
+    // 权限管理（结果值为QList<PermissionInfo>）
+    ApiReply *getPermissionList(int skip = 0, int limit = 100);
+    
+    // 格式化字符串（结果值为格式化后的QString）
+    ApiReply *formatString(const QString &input, const QString &formatType);
+    
+    // 取消所有进行中的请求（包括批次与同步），调用方的句柄收到canceled信号
+    void cancelAll();
+    
+    // 允许指定类型的POST请求在临时故障时自动重试（仅用于服务端幂等的操作），
+    // GET/PUT/DELETE总是允许重试
+    void setRetryPost(const QString &requestType, bool enabled);
+    
+    // 使端点路径以指定前缀开头的缓存响应失效，前缀为空时清空全部缓存
+    void invalidateCache(const QString &endpointPrefix = QString());
+    
+    // 本地实体存储（最近一次获取的用户、角色、权限列表及其快照）
+    EntityStore *entityStore() const { return m_entityStore; }
+    
+    // 获取API基础URL
+    const QString& getBaseUrl() const { return m_baseUrl; }
     
     // 获取当前认证状态
     bool isAuthenticated() const { return !m_authToken.isEmpty(); }
     const QString& getAuthToken() const { return m_authToken; }
     
+    // 后台请求是否处于背压状态（排队过多），此时调用方应暂停提交新的后台工作
+    bool isBackpressured() const { return m_backpressured; }
+    
+    // 排队中的后台请求数
+    int backgroundQueueLength() const { return m_lanes[Background].queue.size(); }
+    
 signals:
-    // 认证相关信号
-    void loginResult(bool success, const QString &message, const QString &token);
-    void logoutResult(bool success, const QString &message);
-    void registerResult(bool success, const QString &message, const UserInfo &userInfo);
-    
-    // 用户管理信号
-    void currentUserInfoResult(bool success, const UserInfo &userInfo, const QString &error);
-    void userListResult(bool success, const QList<UserInfo> &users, const QString &error);
-    void userInfoResult(bool success, const UserInfo &userInfo, const QString &error);
-    void updateUserResult(bool success, const UserInfo &userInfo, const QString &error);
-    
-    // 角色管理信号
-    void roleListResult(bool success, const QList<RoleInfo> &roles, const QString &error);
-    void roleInfoResult(bool success, const RoleInfo &roleInfo, const QString &error);
-    void createRoleResult(bool success, const RoleInfo &roleInfo, const QString &error);
-    void updateRoleResult(bool success, const RoleInfo &roleInfo, const QString &error);
-    void deleteRoleResult(bool success, const QString &message, const QString &error);
-    void assignRoleResult(bool success, const QString &message, const QString &error);
-    void removeRoleResult(bool success, const QString &message, const QString &error);
-    
-    // 权限管理信号
-    void permissionListResult(bool success, const QList<PermissionInfo> &permissions, const QString &error);
-    
-    // 格式化字符串相关信号
-    void formatStringResult(bool success, const QString &result, const QString &error);
-    
-    // 网络错误信号
-    void networkError(const QString &error);
-    
-    // Token过期信号
+    // Token过期信号（刷新令牌也失败后发出）
     void tokenExpired();
-
-private slots:
-    // 处理网络请求完成
-    void onRequestFinished();
     
-    // 处理网络错误
-    void onNetworkError(QNetworkReply::NetworkError error);
+    // 令牌已在后台刷新，调用方应保存新令牌
+    void tokenRefreshed(const QString &token);
+    
+    // 背压状态变化，backpressured为false时可以继续提交后台工作
+    void backpressureChanged(bool backpressured);
 
 private:
-    QNetworkAccessManager *m_networkManager;
+    // 套接字读写与响应解码在专用网络线程中进行，解码结果随响应整体送回界面线程
+    NetworkThread *m_network;
     QString m_baseUrl;
     QString m_authToken;
     
-    // 发送POST请求
-    void sendPostRequest(const QString &endpoint, const QJsonObject &data, const QString &requestType);
+    // 令牌刷新：按JWT的exp声明在过期前刷新（POST /auth/refresh，服务端没有该接口时用凭据静默重新登录）；
+    // 与过期赛跑而收到401的请求挂起，刷新完成后用新令牌重发
+    QTimer *m_refreshTimer;
+    int m_refreshMarginMs;
+    bool m_refreshing;
+    bool m_refreshEndpointMissing;
+    QString m_username;
+    QString m_password;
+    QList<std::function<void(bool)>> m_authWaiters;
+    
+    // 多节点：server/urls配置的其他节点与m_baseUrl一起探测，m_baseUrl始终是当前选中的节点
+    EndpointSelector *m_endpoints;
+    QStringList m_extraBaseUrls;
+    
+    // 响应缓存：内存层按端点有效期缓存，可选的磁盘层由网络线程中的QNetworkDiskCache提供
+    ResponseCache m_responseCache;
+    
+    // 本地实体存储
+    EntityStore *m_entityStore;
+    
+    // 超时设置（毫秒，0表示不限制）：整体超时、连接超时、连续无数据的读取超时
+    int m_timeoutMs;
+    int m_connectTimeoutMs;
+    int m_readTimeoutMs;
+    
+    // 批次状态
+    struct BatchState {
+        QPointer<ApiReply> reply;
+        QList<BatchOperation> operations;
+        Priority priority = Background;
+        int nextIndex = 0;
+        QList<int> requeued;    // 需要逐个重发的操作序号，先于未发出的操作发出
+        int inFlight = 0;
+        int completed = 0;
+        int maxConcurrent = 0;
+        QHash<int, int> attempts;
+        int intervalMs = 0;
+        qint64 nextDispatchAt = 0;
+        bool pumpScheduled = false;
+        QList<BatchOperation> failed;
+        QStringList errors;
+    };
+    QHash<int, BatchState> m_batches;
+    int m_nextBatchId;
+    
+    // 增量同步状态
+    struct SyncState {
+        QPointer<ApiReply> reply;
+        QString path;
+        Priority priority = Background;
+        QString since;
+        int skip = 0;
+        bool delta = false;
+        QList<UserInfo> users;
+        QList<RoleInfo> roles;
+        QList<int> deletedIds;
+        QString maxUpdatedAt;
+    };
+    QHash<int, SyncState> m_syncs;
+    int m_nextSyncId;
+    
+    // 在途请求：同一网络请求可被多个请求句柄共享（相同GET合并），
+    // 重试时换用新的网络请求，请求ID保持不变
+    struct PendingRequest {
+        NetworkCall *reply = nullptr;
+        Priority priority = Interactive;
+        bool queued = false;
+        QByteArray method;
+        QNetworkRequest request;
+        QByteArray body;
+        QByteArray plainBody;   // 请求体压缩前的内容，服务端拒绝压缩时改用它重发
+        int attempt = 0;
+        QString requestType;
+        QString coalesceKey;
+        QString cacheKey;
+        QString path;
+        QList<QPointer<ApiReply>> subscribers;
+    };
+    QHash<int, PendingRequest> m_pending;
+    int m_nextRequestId;
+    
+    // 可合并的在途GET请求，键为方法、完整URL（含查询参数）与令牌，值为请求ID
+    QHash<QString, int> m_inFlightGets;
+    
+    // 请求调度：按优先级分道排队，交互请求先于后台请求发出；
+    // 总并发不超过每主机连接数，后台请求最多占用其中一部分，为交互请求保留余量
+    struct Lane {
+        int inFlight = 0;
+        QList<std::function<NetworkCall*()>> queue;
+    };
+    Lane m_lanes[2];
+    int m_maxConnections;
+    
+    // HTTP/2：连接协商为HTTP/2后请求在同一连接上多路复用，并发上限提高到m_http2MaxStreams
+    bool m_http2Enabled;
+    bool m_http2Active;
+    int m_http2MaxStreams;
+    
+    // TLS会话票据跨启动保存，下次启动的首个HTTPS连接恢复会话而不做完整握手
+    bool m_tlsSessionReuse;
+    TlsSessionCache m_tlsSessions;
+    int m_interactiveReserve;
+    bool m_schedulerPumpScheduled;
+    
+    // 后台请求限流：令牌桶限制发出速率，并发上限与速率按AIMD自适应
+    // （正常响应时加性增加，429/503或延迟明显升高时乘性减少）
+    double m_rateLimit;
+    double m_maxRateLimit;
+    double m_rateBurst;
+    double m_rateTokens;
+    qint64 m_rateUpdatedAt;
+    double m_backgroundLimit;
+    double m_latencyBaselineMs;
+    qint64 m_lastDecreaseAt;
+    bool m_backpressured;
+    
+    // 重试设置：最大重试次数、允许重试的POST请求类型、重试预算
+    int m_retryCount;
+    QSet<QString> m_retryablePostTypes;
+    double m_retryBudget;
+    
+    // 请求体压缩：超过阈值的请求体以deflate编码发送，服务端返回415后对该服务器停用
+    bool m_compressRequests;
+    int m_compressThreshold;
+    bool m_compressionRejected;
+    
+    // 列表类请求是否声明接受CBOR响应（服务端不支持时照常返回JSON）
+    bool m_acceptCbor;
+    
+    // 批量操作每m_batchSize个打包为一个POST /batch请求；服务端返回404/405/501后对该服务器改为逐个请求
+    bool m_batchEnvelope;
+    int m_batchSize;
+    bool m_batchEndpointMissing;
+    
+    // 列表请求只取表格需要的字段；服务端以400/422拒绝时去掉投影参数重发，此后对该服务器不再使用
+    bool m_fieldProjection;
+    bool m_projectionRejected;
     
-    // 发送GET请求
-    void sendGetRequest(const QString &endpoint, const QString &requestType);
+    // 构造带认证头的请求
+    QNetworkRequest buildRequest(const QString &endpoint, const QString &requestType) const;
     
-    // 发送PUT请求
-    void sendPutRequest(const QString &endpoint, const QJsonObject &data, const QString &requestType);
+    // 切换实际使用的基础URL（重置与服务器相关的协商状态）
+    void applyBaseUrl(const QString &url);
     
-    // 发送DELETE请求
-    void sendDeleteRequest(const QString &endpoint, const QString &requestType);
+    // 能否在收到401时刷新令牌
+    bool canRefreshToken() const;
     
-    // 处理响应数据
-    void handleResponse(QNetworkReply *reply, const QString &requestType);
+    // 刷新令牌，完成后调用finishTokenRefresh
+    void refreshToken();
+    void reloginSilently();
+    void finishTokenRefresh(bool refreshed);
+    
+    // 请求因401失败时挂起，令牌刷新后以resume(true)继续，刷新失败以resume(false)结束；
+    // sentAuthorization为请求发出时的认证头，令牌已更新时立即继续
+    void awaitTokenRefresh(const QByteArray &sentAuthorization, std::function<void(bool)> resume);
+    
+    // 从JWT中读取过期时间（毫秒时间戳），无法解析返回0
+    static qint64 tokenExpiry(const QString &token);
+    
+    // 是否为连接层面的失败（节点不可达），用于节点故障切换
+    static bool isConnectionFailure(NetworkCall *reply);
+    
+    // 为HTTPS请求附加TLS配置（会话恢复）
+    void applyTlsSession(QNetworkRequest &request) const;
+    
+    // 按HTTP方法发出请求（在网络线程中执行），给出请求类型时响应也在网络线程中解码
+    NetworkCall *dispatchRequest(const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+                                 const QString &requestType = QString());
+    
+    // 发送请求并返回请求句柄，响应在handleResponse中解码后送达该句柄
+    ApiReply *sendRequest(const QByteArray &method, const QString &endpoint, const QString &requestType,
+                          const QJsonObject &data = QJsonObject(), Priority priority = Interactive);
+    
+    // 读取缓存配置（各端点有效期、磁盘缓存）
+    void loadCacheSettings();
+    
+    // 读取网络配置（超时）
+    void loadNetworkSettings();
+    
+    // 生成字段投影查询参数（以&开头），未启用或服务端不支持时返回空字符串
+    QString projectionQuery(const QStringList &fields, bool includePermissions) const;
+    
+    // 按配置压缩请求体并设置Content-Encoding，返回是否进行了压缩
+    bool compressBody(QNetworkRequest &request, QByteArray &body) const;
+    
+    // 请求标识：完整URL（含查询参数）与令牌，用于缓存键与合并键
+    QString requestKey(const QNetworkRequest &request) const;
+    
+    // 计算GET请求的合并键
+    QString coalesceKey(const QByteArray &method, const QNetworkRequest &request) const;
+    
+    // 权限列表首页结果写入本地实体存储
+    void updateEntityStore(const QString &requestType, const QUrl &url, const ApiResult &result);
+    
+    // 写操作成功后使受影响的缓存失效
+    void invalidateAfterMutation(const QString &requestType);
+    
+    // 将请求句柄挂到在途请求上，句柄取消时仅移除自身，全部取消后才中止网络请求
+    void attachSubscriber(int requestId, ApiReply *apiReply);
+    void detachSubscriber(int requestId, ApiReply *apiReply);
+    
+    // 发出（或重新发出）在途请求，经调度器按优先级排队
+    void dispatchPending(int requestId);
+    
+    // 将发出请求的任务加入对应优先级的队列；任务返回nullptr表示请求已取消，不占用并发
+    void scheduleDispatch(Priority priority, std::function<NetworkCall*()> job);
+    
+    // 在并发限制内从队列中发出请求
+    void pumpScheduler();
+    
+    // 当前的并发请求上限（HTTP/2连接不受每主机6个连接的限制）
+    int connectionLimit() const;
+    
+    // 取一个后台请求令牌，不足时返回需要等待的毫秒数，否则返回0
+    int takeRateToken();
+    
+    // 根据请求结果调整后台并发上限与速率
+    void adaptRateLimit(Priority priority, qint64 latencyMs, int statusCode);
+    
+    // 更新背压状态，解除时继续推进等待中的批次
+    void updateBackpressure();
+    
+    // 结束在途请求，移出合并表
+    PendingRequest takePending(int requestId);
+    
+    // 判断失败的请求是否重试，返回等待时间（毫秒），不重试返回-1
+    int retryDelay(NetworkCall *reply, const QByteArray &method, const QString &requestType, int attempt);
+    
+    // 每个新请求为重试预算补充少量额度
+    void depositRetryBudget();
+    
+    // 开始同步指定端点的实体目录
+    ApiReply *startSync(const QString &path, Priority priority);
+    
+    // 请求同步的下一页
+    void fetchSyncPage(int syncId);
+    
+    // 处理同步页响应
+    void handleSyncPage(int syncId, ApiReply *reply);
+    
+    // 全部页面到齐后合并到本地实体存储
+    void finishSync(int syncId);
+    
+    // 按并发与速率限制发出批次中排队的操作
+    void pumpBatch(int batchId);
+    
+    // 批量操作对应的单个请求
+    struct BatchRequest {
+        QByteArray method;
+        QString endpoint;
+        QString requestType;
+        QJsonObject data;
+    };
+    static BatchRequest batchRequestFor(const BatchOperation &operation);
+    
+    // 发出批次中的单个操作
+    void sendBatchOperation(int batchId, int index);
+    
+    // 将批次中从index开始的count个操作打包为一个批量请求发出
+    void sendBatchEnvelope(int batchId, int index, int count);
+    
+    // 处理批次中单个操作的响应
+    void handleBatchReply(NetworkCall *reply, int batchId, int index, const QByteArray &method);
+    
+    // 处理批量请求的响应，按操作拆分结果；results为空且error非空时整段操作失败
+    void handleBatchEnvelopeReply(NetworkCall *reply, int batchId, int index, int count, bool compressed);
+    void finishBatchEnvelope(int batchId, int index, int count, const QJsonArray &results, const QString &error);
+    
+    // 记录一个操作的结果；releaseRequest为false时不释放在途请求名额（批量请求整体释放一次）
+    void finishBatchOperation(int batchId, int index, bool success, const QString &error, bool releaseRequest = true);
+    
+    // 处理响应数据，解码一次后送达所有挂在该请求上的句柄
+    void handleResponse(int requestId, NetworkCall *reply);
+    
+    // 按请求类型解码响应并更新会话状态（缓存内容与令牌过期在调用线程中解码）
+    ApiResult decodeResponse(int statusCode, const QByteArray &responseData, const QByteArray &contentType,
+                             const QString &requestType, const QString &errorString);
+    
+    // 按请求类型解码响应，不访问任何成员，可在网络线程中执行
+    static ApiResult parseResponse(int statusCode, const QByteArray &responseData, const QByteArray &contentType,
+                                   const QString &requestType, const QString &errorString);
+    
+    // 按解码结果更新会话状态（令牌过期、登录与注销），只在调用线程中执行
+    void applySessionResult(const QString &requestType, const ApiResult &result);
     
     // 数据解析辅助方法
-    UserInfo parseUserInfo(const QJsonObject &json);
-    RoleInfo parseRoleInfo(const QJsonObject &json);
-    PermissionInfo parsePermissionInfo(const QJsonObject &json);
-    QList<UserInfo> parseUserList(const QJsonArray &jsonArray);
-    QList<RoleInfo> parseRoleList(const QJsonArray &jsonArray);
-    QList<PermissionInfo> parsePermissionList(const QJsonArray &jsonArray);
+    static UserInfo parseUserInfo(const QJsonObject &json);
+    static RoleInfo parseRoleInfo(const QJsonObject &json);
+    static PermissionInfo parsePermissionInfo(const QJsonObject &json);
+    static QList<UserInfo> parseUserList(const QJsonArray &jsonArray);
+    static QList<RoleInfo> parseRoleList(const QJsonArray &jsonArray);
+    static QList<PermissionInfo> parsePermissionList(const QJsonArray &jsonArray);
+    
+    // 从列表响应中取出数组（兼容直接返回数组和包含items字段的对象）
+    static QJsonArray extractItems(const QJsonDocument &doc);
 };
 
 #endif // APIMANAGER_H
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "apireply.h"
+
+/**
+ * API请求句柄构造函数
+ */
+ApiReply::ApiReply(QObject *parent)
+    : QObject(parent)
+    , m_finished(false)
+    , m_canceled(false)
+{
+}
+
+/**
+ * 注册完成回调
+ */
+ApiReply *ApiReply::then(QObject *context, std::function<void(ApiReply*)> callback)
+{
+    if (m_canceled) {
+        return this;
+    }
+    
+    if (m_finished) {
+        // 已完成但尚未释放，直接回调
+        if (context) {
+            callback(this);
+        }
+        return this;
+    }
+    
+    connect(this, &ApiReply::finished, context, [this, callback]() {
+        callback(this);
+    });
+    return this;
+}
+
+/**
+ * 取消请求
+ */
+void ApiReply::cancel()
+{
+    if (m_finished || m_canceled) {
+        return;
+    }
+    
+    m_canceled = true;
+    emit canceled();
+    deleteLater();
+}
+
+/**
+ * 请求完成
+ */
+void ApiReply::resolve(const ApiResult &result)
+{
+    if (m_finished || m_canceled) {
+        return;
+    }
+    
+    m_result = result;
+    m_finished = true;
+    emit finished();
+    deleteLater();
+}
+
+/**
+ * 更新进度
+ */
+void ApiReply::setProgress(int completed, int total)
+{
+    if (m_finished || m_canceled) {
+        return;
+    }
+    emit progress(completed, total);
+}
@@ -0,0 +1,89 @@
+#ifndef APIREPLY_H
+#define APIREPLY_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariant>
+#include <functional>
+
+// 单次API请求的解码结果
+struct ApiResult {
+    bool success = false;
+    QVariant value;
+    QString message;
+    QString error;
+    int statusCode = 0;
+};
+
+Q_DECLARE_METATYPE(ApiResult)
+
+/**
+ * 单次API请求的句柄
+ * ApiManager的每个请求方法都返回一个ApiReply，结果只会送达发起请求的调用方，
+ * 调用方通过then()注册完成回调，或通过cancel()取消请求。
+ * ApiReply由ApiManager持有，完成或取消后自动释放，调用方如需保存指针请使用QPointer
+ */
+class ApiReply : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ApiReply(QObject *parent = nullptr);
+    
+    /**
+     * 请求状态
+     */
+    bool isFinished() const { return m_finished; }
+    bool isCanceled() const { return m_canceled; }
+    bool isSuccess() const { return m_result.success; }
+    
+    /**
+     * 请求结果
+     */
+    const ApiResult &result() const { return m_result; }
+    QString message() const { return m_result.message; }
+    QString error() const { return m_result.error; }
+    int statusCode() const { return m_result.statusCode; }
+    
+    template<typename T>
+    T value() const { return m_result.value.value<T>(); }
+    
+    /**
+     * 注册完成回调
+     * 回调绑定到context对象，context销毁后不再调用；请求取消时不会调用
+     */
+    ApiReply *then(QObject *context, std::function<void(ApiReply*)> callback);
+    
+    /**
+     * 取消请求
+     */
+    void cancel();
+    
+    /**
+     * 由ApiManager调用：请求完成
+     */
+    void resolve(const ApiResult &result);
+    
+    /**
+     * 由ApiManager调用：更新进度（批量操作）
+     */
+    void setProgress(int completed, int total);
+
+signals:
+    // 请求完成
+    void finished();
+    
+    // 请求被取消
+    void canceled();
+    
+    // 进度更新
+    void progress(int completed, int total);
+
+private:
+    ApiResult m_result;
+    bool m_finished;
+    bool m_canceled;
+};
+
+#endif // APIREPLY_H
@@ -0,0 +1,293 @@
+#include "cbordecoder.h"
+#include <QCborStreamReader>
+#include <QCborValue>
+#include <QJsonArray>
+#include <QJsonValue>
+
+/**
+ * 判断Content-Type是否为CBOR
+ */
+bool CborDecoder::isCbor(const QByteArray &contentType)
+{
+    return contentType.trimmed().toLower().startsWith("application/cbor");
+}
+
+bool CborDecoder::decodeUsers(const QByteArray &data, QList<UserInfo> *users)
+{
+    return decodeList(data, users, &CborDecoder::readUser);
+}
+
+bool CborDecoder::decodeRoles(const QByteArray &data, QList<RoleInfo> *roles)
+{
+    return decodeList(data, roles, &CborDecoder::readRole);
+}
+
+bool CborDecoder::decodePermissions(const QByteArray &data, QList<PermissionInfo> *permissions)
+{
+    return decodeList(data, permissions, &CborDecoder::readPermission);
+}
+
+bool CborDecoder::decodeUserSyncPage(const QByteArray &data, SyncPage *page)
+{
+    return decodeList(data, &page->users, &CborDecoder::readUser, page);
+}
+
+bool CborDecoder::decodeRoleSyncPage(const QByteArray &data, SyncPage *page)
+{
+    return decodeList(data, &page->roles, &CborDecoder::readRole, page);
+}
+
+/**
+ * 将CBOR文档转换为JSON文档
+ */
+bool CborDecoder::toJsonDocument(const QByteArray &data, QJsonDocument *doc, QString *errorString)
+{
+    QCborParserError parseError;
+    QCborValue value = QCborValue::fromCbor(data, &parseError);
+    if (parseError.error != QCborError::NoError) {
+        *errorString = parseError.errorString();
+        return false;
+    }
+    
+    QJsonValue json = value.toJsonValue();
+    *doc = json.isArray() ? QJsonDocument(json.toArray()) : QJsonDocument(json.toObject());
+    return true;
+}
+
+/**
+ * 解码列表响应
+ * 顶层为数组时直接逐项读取；为对象时读取items字段，给出同步页时另外读取deleted_ids，其余字段跳过
+ */
+template<typename T>
+bool CborDecoder::decodeList(const QByteArray &data, QList<T> *list, bool (*readItem)(QCborStreamReader &, T *),
+                             SyncPage *page)
+{
+    QCborStreamReader reader(data);
+    
+    // 跳过可选的自描述标记（55799）
+    if (reader.isTag() && reader.toTag() == QCborTag(QCborKnownTags::Signature)) {
+        reader.next();
+    }
+    
+    auto readArray = [&]() -> bool {
+        if (!reader.isArray() || !reader.enterContainer()) {
+            return false;
+        }
+        if (reader.isLengthKnown()) {
+            list->reserve(list->size() + int(reader.length()));
+        }
+        while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+            T item;
+            if (!readItem(reader, &item)) {
+                return false;
+            }
+            list->append(item);
+        }
+        return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+    };
+    
+    if (reader.isArray()) {
+        return readArray();
+    }
+    
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key = readString(reader);
+        if (key == "items") {
+            if (!readArray()) {
+                return false;
+            }
+        } else if (page && key == "deleted_ids") {
+            if (!reader.isArray() || !reader.enterContainer()) {
+                return false;
+            }
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                page->deletedIds.append(int(readInteger(reader)));
+            }
+            if (reader.lastError() != QCborError::NoError || !reader.leaveContainer()) {
+                return false;
+            }
+            page->hasDeletedIds = true;
+        } else {
+            reader.next();
+        }
+    }
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+/**
+ * 读取用户对象
+ */
+bool CborDecoder::readUser(QCborStreamReader &reader, UserInfo *user)
+{
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key = readString(reader);
+        if (key == "id") {
+            user->id = int(readInteger(reader));
+        } else if (key == "username") {
+            user->username = readString(reader);
+        } else if (key == "email") {
+            user->email = readString(reader);
+        } else if (key == "full_name") {
+            user->fullName = readString(reader);
+        } else if (key == "is_active") {
+            user->isActive = readBool(reader);
+        } else if (key == "created_at") {
+            user->createdAt = readString(reader);
+        } else if (key == "updated_at") {
+            user->updatedAt = readString(reader);
+        } else if (key == "last_login") {
+            user->lastLogin = readString(reader);
+        } else if (key == "roles" && reader.isArray() && reader.enterContainer()) {
+            // 角色可以是名称字符串，也可以是带name字段的对象
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                if (reader.isString()) {
+                    user->roles.append(readString(reader));
+                } else if (reader.isMap()) {
+                    RoleInfo role;
+                    if (!readRole(reader, &role)) {
+                        return false;
+                    }
+                    user->roles.append(role.name);
+                } else {
+                    reader.next();
+                }
+            }
+            reader.leaveContainer();
+        } else {
+            reader.next();
+        }
+    }
+    
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+/**
+ * 读取角色对象
+ */
+bool CborDecoder::readRole(QCborStreamReader &reader, RoleInfo *role)
+{
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    
+    bool hasPermissions = false;
+    int permissionCount = 0;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key = readString(reader);
+        if (key == "id") {
+            role->id = int(readInteger(reader));
+        } else if (key == "name") {
+            role->name = readString(reader);
+        } else if (key == "display_name") {
+            role->displayName = readString(reader);
+        } else if (key == "description") {
+            role->description = readString(reader);
+        } else if (key == "is_active") {
+            role->isActive = readBool(reader);
+        } else if (key == "created_at") {
+            role->createdAt = readString(reader);
+        } else if (key == "updated_at") {
+            role->updatedAt = readString(reader);
+        } else if (key == "permission_count") {
+            permissionCount = int(readInteger(reader));
+        } else if (key == "permissions" && reader.isArray() && reader.enterContainer()) {
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                PermissionInfo permission;
+                if (!readPermission(reader, &permission)) {
+                    return false;
+                }
+                role->permissions.append(permission);
+            }
+            reader.leaveContainer();
+            hasPermissions = true;
+        } else {
+            reader.next();
+        }
+    }
+    role->permissionCount = hasPermissions ? role->permissions.size() : permissionCount;
+    
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+/**
+ * 读取权限对象
+ */
+bool CborDecoder::readPermission(QCborStreamReader &reader, PermissionInfo *permission)
+{
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key = readString(reader);
+        if (key == "id") {
+            permission->id = int(readInteger(reader));
+        } else if (key == "name") {
+            permission->name = readString(reader);
+        } else if (key == "display_name") {
+            permission->displayName = readString(reader);
+        } else if (key == "description") {
+            permission->description = readString(reader);
+        } else if (key == "resource") {
+            permission->resource = readString(reader);
+        } else if (key == "action") {
+            permission->action = readString(reader);
+        } else {
+            reader.next();
+        }
+    }
+    
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+/**
+ * 读取文本字符串（可能分块），其他类型（如null）跳过并返回空字符串
+ */
+QString CborDecoder::readString(QCborStreamReader &reader)
+{
+    if (!reader.isString()) {
+        reader.next();
+        return QString();
+    }
+    
+    QString result;
+    auto chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        result += chunk.data;
+        chunk = reader.readString();
+    }
+    return result;
+}
+
+/**
+ * 读取整数，其他类型跳过并返回0
+ */
+qint64 CborDecoder::readInteger(QCborStreamReader &reader)
+{
+    qint64 value = 0;
+    if (reader.isInteger()) {
+        value = reader.toInteger();
+    }
+    reader.next();
+    return value;
+}
+
+/**
+ * 读取布尔值，其他类型跳过并返回false
+ */
+bool CborDecoder::readBool(QCborStreamReader &reader)
+{
+    bool value = false;
+    if (reader.isBool()) {
+        value = reader.toBool();
+    }
+    reader.next();
+    return value;
+}
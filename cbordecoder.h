@@ -0,0 +1,58 @@
+#ifndef CBORDECODER_H
+#define CBORDECODER_H
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QList>
+#include <QString>
+#include "apimanager.h"
+
+class QCborStreamReader;
+
+/**
+ * CBOR响应解码
+ * 列表响应与增量同步页用流式读取器直接解码为UserInfo/RoleInfo/PermissionInfo，
+ * 不经过中间的JSON文档；字段名与JSON响应一致，顶层可以是数组或带items字段的对象
+ */
+class CborDecoder
+{
+public:
+    /**
+     * 判断Content-Type是否为CBOR
+     */
+    static bool isCbor(const QByteArray &contentType);
+    
+    /**
+     * 解码用户/角色/权限列表，数据格式错误返回false
+     */
+    static bool decodeUsers(const QByteArray &data, QList<UserInfo> *users);
+    static bool decodeRoles(const QByteArray &data, QList<RoleInfo> *roles);
+    static bool decodePermissions(const QByteArray &data, QList<PermissionInfo> *permissions);
+    
+    /**
+     * 解码增量同步页：items解码为实体，deleted_ids读入page->deletedIds，
+     * 顶层为数组（完整列表）时hasDeletedIds为false
+     */
+    static bool decodeUserSyncPage(const QByteArray &data, SyncPage *page);
+    static bool decodeRoleSyncPage(const QByteArray &data, SyncPage *page);
+    
+    /**
+     * 将CBOR文档转换为JSON文档，用于错误响应等按JSON处理的响应
+     */
+    static bool toJsonDocument(const QByteArray &data, QJsonDocument *doc, QString *errorString);
+    
+private:
+    template<typename T>
+    static bool decodeList(const QByteArray &data, QList<T> *list, bool (*readItem)(QCborStreamReader &, T *),
+                           SyncPage *page = nullptr);
+    
+    static bool readUser(QCborStreamReader &reader, UserInfo *user);
+    static bool readRole(QCborStreamReader &reader, RoleInfo *role);
+    static bool readPermission(QCborStreamReader &reader, PermissionInfo *permission);
+    
+    static QString readString(QCborStreamReader &reader);
+    static qint64 readInteger(QCborStreamReader &reader);
+    static bool readBool(QCborStreamReader &reader);
+};
+
+#endif // CBORDECODER_H
@@ -0,0 +1,453 @@
+#include "changefeed.h"
+#include "entitystore.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QSettings>
+
+namespace {
+
+// 重连退避上限
+const int MaxReconnectDelayMs = 60 * 1000;
+
+// 连续失败多少次后改为轮询
+const int MaxPushFailures = 5;
+
+// 超过该时间没有收到任何数据（包括心跳注释行）视为连接已失效
+const int StreamIdleTimeoutMs = 90 * 1000;
+
+// 轮询模式下尝试恢复推送的间隔
+const int PushRetryIntervalMs = 5 * 60 * 1000;
+
+}
+
+/**
+ * 变更推送通道构造函数
+ * 事件流长期占用一条连接，使用独立的QNetworkAccessManager，不占用普通API请求的连接
+ */
+ChangeFeed::ChangeFeed(ApiManager *apiManager, QObject *parent)
+    : QObject(parent)
+    , m_apiManager(apiManager)
+    , m_networkManager(new QNetworkAccessManager(this))
+    , m_running(false)
+    , m_awaitingToken(false)
+    , m_pushActive(false)
+    , m_pushSupported(true)
+    , m_failures(0)
+    , m_reconnectDelayMs(1000)
+    , m_changedSincePoll(false)
+    , m_syncUsersPending(false)
+    , m_syncRolesPending(false)
+{
+    QSettings settings;
+    m_pushSupported = settings.value("sync/push_enabled", true).toBool();
+    m_minPollIntervalSec = qMax(5, settings.value("sync/poll_interval", 15).toInt());
+    m_maxPollIntervalSec = qMax(m_minPollIntervalSec, settings.value("sync/max_poll_interval", 300).toInt());
+    m_pollIntervalSec = m_minPollIntervalSec;
+    
+    m_reconnectTimer.setSingleShot(true);
+    m_pollTimer.setSingleShot(true);
+    m_watchdogTimer.setSingleShot(true);
+    m_watchdogTimer.setInterval(StreamIdleTimeoutMs);
+    m_syncTimer.setSingleShot(true);
+    m_syncTimer.setInterval(300);
+    
+    connect(&m_reconnectTimer, &QTimer::timeout, this, &ChangeFeed::onReconnectTimeout);
+    connect(&m_pollTimer, &QTimer::timeout, this, &ChangeFeed::onPollTimeout);
+    connect(&m_watchdogTimer, &QTimer::timeout, this, &ChangeFeed::onWatchdogTimeout);
+    connect(&m_syncTimer, &QTimer::timeout, this, &ChangeFeed::onSyncTimeout);
+    
+    EntityStore *store = m_apiManager->entityStore();
+    connect(store, &EntityStore::usersChanged, this, &ChangeFeed::onStoreChanged);
+    connect(store, &EntityStore::rolesChanged, this, &ChangeFeed::onStoreChanged);
+    
+    // 令牌刷新后恢复因401断开的事件流
+    connect(m_apiManager, &ApiManager::tokenRefreshed, this, &ChangeFeed::onTokenRefreshed);
+}
+
+/**
+ * 析构函数
+ */
+ChangeFeed::~ChangeFeed()
+{
+    closeStream();
+}
+
+/**
+ * 开始接收变更
+ */
+void ChangeFeed::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_awaitingToken = false;
+    m_failures = 0;
+    m_reconnectDelayMs = 1000;
+    
+    if (m_pushSupported) {
+        connectStream();
+    } else {
+        startPolling();
+    }
+}
+
+/**
+ * 停止接收变更
+ */
+void ChangeFeed::stop()
+{
+    m_running = false;
+    m_awaitingToken = false;
+    m_reconnectTimer.stop();
+    m_pollTimer.stop();
+    m_syncTimer.stop();
+    closeStream();
+    setPushActive(false);
+}
+
+/**
+ * 建立事件流连接
+ */
+void ChangeFeed::connectStream()
+{
+    closeStream();
+    
+    QNetworkRequest request(QUrl(m_apiManager->getBaseUrl() + "/events/stream"));
+    request.setRawHeader("Accept", "text/event-stream");
+    request.setRawHeader("Cache-Control", "no-cache");
+    m_streamToken = m_apiManager->getAuthToken();
+    request.setRawHeader("Authorization", ("Bearer " + m_streamToken).toUtf8());
+    if (!m_lastEventId.isEmpty()) {
+        // 服务端可据此补发断线期间的事件
+        request.setRawHeader("Last-Event-ID", m_lastEventId);
+    }
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    
+    qDebug() << "[DEBUG] ChangeFeed: connecting to" << request.url().toString();
+    
+    m_buffer.clear();
+    m_stream = m_networkManager->get(request);
+    connect(m_stream, &QNetworkReply::readyRead, this, &ChangeFeed::onStreamReadyRead);
+    connect(m_stream, &QNetworkReply::finished, this, &ChangeFeed::onStreamFinished);
+    m_watchdogTimer.start();
+}
+
+/**
+ * 断开事件流连接
+ */
+void ChangeFeed::closeStream()
+{
+    m_watchdogTimer.stop();
+    if (m_stream) {
+        QNetworkReply *stream = m_stream;
+        m_stream = nullptr;
+        stream->disconnect(this);
+        stream->abort();
+        stream->deleteLater();
+    }
+}
+
+/**
+ * 接收事件流数据
+ * 事件之间以空行分隔，每行为"字段: 值"，以冒号开头的行是心跳注释
+ */
+void ChangeFeed::onStreamReadyRead()
+{
+    if (!m_stream) {
+        return;
+    }
+    
+    m_watchdogTimer.start();
+    
+    if (!m_pushActive) {
+        int statusCode = m_stream->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (statusCode != 200) {
+            return;
+        }
+        
+        // 连接建立后同步一次，补齐断线期间可能错过的变更
+        qDebug() << "[DEBUG] ChangeFeed: push channel established";
+        m_failures = 0;
+        m_reconnectDelayMs = 1000;
+        m_pollTimer.stop();
+        setPushActive(true);
+        scheduleSync(true, true);
+    }
+    
+    m_buffer.append(m_stream->readAll());
+    m_buffer.replace("\r\n", "\n");
+    
+    int end;
+    while ((end = m_buffer.indexOf("\n\n")) >= 0) {
+        QByteArray block = m_buffer.left(end);
+        m_buffer.remove(0, end + 2);
+        
+        QByteArray type = "message";
+        QByteArray data;
+        const QList<QByteArray> lines = block.split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.isEmpty() || line.startsWith(':')) {
+                continue;
+            }
+            int colon = line.indexOf(':');
+            QByteArray field = colon >= 0 ? line.left(colon) : line;
+            QByteArray value = colon >= 0 ? line.mid(colon + 1) : QByteArray();
+            if (value.startsWith(' ')) {
+                value.remove(0, 1);
+            }
+            
+            if (field == "event") {
+                type = value;
+            } else if (field == "data") {
+                if (!data.isEmpty()) {
+                    data.append('\n');
+                }
+                data.append(value);
+            } else if (field == "id") {
+                m_lastEventId = value;
+            } else if (field == "retry") {
+                bool ok = false;
+                int retryMs = value.toInt(&ok);
+                if (ok && retryMs > 0) {
+                    m_reconnectDelayMs = qMin(retryMs, MaxReconnectDelayMs);
+                }
+            }
+        }
+        
+        if (!data.isEmpty()) {
+            handleEvent(type, data);
+        }
+    }
+}
+
+/**
+ * 事件流结束（服务端关闭、网络错误或不支持推送）
+ */
+void ChangeFeed::onStreamFinished()
+{
+    QNetworkReply *stream = m_stream;
+    if (!stream) {
+        return;
+    }
+    m_stream = nullptr;
+    m_watchdogTimer.stop();
+    stream->deleteLater();
+    
+    int statusCode = stream->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    bool wasActive = m_pushActive;
+    setPushActive(false);
+    
+    if (!m_running) {
+        return;
+    }
+    
+    if (statusCode == 404 || statusCode == 405 || statusCode == 501) {
+        // 服务端没有推送接口
+        qDebug() << "[DEBUG] ChangeFeed: push not supported (HTTP" << statusCode << "), polling instead";
+        startPolling();
+        return;
+    }
+    
+    if (statusCode == 401) {
+        // 令牌在连接之后已经刷新，用新令牌重连
+        if (m_apiManager->getAuthToken() != m_streamToken) {
+            qDebug() << "[DEBUG] ChangeFeed: stream unauthorized, reconnecting with refreshed token";
+            connectStream();
+            return;
+        }
+        
+        // 等待会话层刷新令牌后重连；补做的同步请求同样会收到401并触发刷新，
+        // 刷新失败时会话层发出tokenExpired并停止订阅
+        qDebug() << "[DEBUG] ChangeFeed: stream unauthorized, waiting for token refresh";
+        m_awaitingToken = true;
+        scheduleSync(true, true);
+        return;
+    }
+    
+    if (wasActive) {
+        // 已建立的连接被正常关闭，尽快重连
+        qDebug() << "[DEBUG] ChangeFeed: stream closed, reconnecting";
+    } else {
+        m_failures++;
+        qDebug() << "[DEBUG] ChangeFeed: stream failed (" << stream->errorString() << "), attempt" << m_failures;
+        if (m_failures >= MaxPushFailures) {
+            startPolling();
+            return;
+        }
+    }
+    
+    scheduleReconnect();
+}
+
+/**
+ * 令牌已刷新，恢复因401断开的事件流
+ */
+void ChangeFeed::onTokenRefreshed()
+{
+    if (!m_running || !m_awaitingToken) {
+        return;
+    }
+    m_awaitingToken = false;
+    qDebug() << "[DEBUG] ChangeFeed: token refreshed, reconnecting stream";
+    connectStream();
+}
+
+/**
+ * 按退避时间安排重连
+ * 使用全抖动退避，避免大量客户端在服务端恢复后同时重连
+ */
+void ChangeFeed::scheduleReconnect()
+{
+    int delay = m_reconnectDelayMs / 2 + int(QRandomGenerator::global()->bounded(m_reconnectDelayMs / 2 + 1));
+    m_reconnectDelayMs = qMin(m_reconnectDelayMs * 2, MaxReconnectDelayMs);
+    m_reconnectTimer.start(delay);
+}
+
+/**
+ * 重连定时器到期
+ */
+void ChangeFeed::onReconnectTimeout()
+{
+    if (m_running) {
+        connectStream();
+    }
+}
+
+/**
+ * 切换到轮询模式
+ */
+void ChangeFeed::startPolling()
+{
+    qDebug() << "[DEBUG] ChangeFeed: adaptive polling every" << m_pollIntervalSec << "s";
+    m_pollTimer.start(m_pollIntervalSec * 1000);
+    
+    // 定期尝试恢复推送
+    if (m_pushSupported) {
+        m_failures = 0;
+        m_reconnectDelayMs = 1000;
+        m_reconnectTimer.start(PushRetryIntervalMs);
+    }
+}
+
+/**
+ * 轮询定时器到期
+ * 上一轮有变化时恢复最短间隔，否则间隔加倍直到上限
+ */
+void ChangeFeed::onPollTimeout()
+{
+    if (!m_running || m_pushActive) {
+        return;
+    }
+    
+    if (m_changedSincePoll) {
+        m_pollIntervalSec = m_minPollIntervalSec;
+    } else {
+        m_pollIntervalSec = qMin(m_pollIntervalSec * 2, m_maxPollIntervalSec);
+    }
+    m_changedSincePoll = false;
+    
+    scheduleSync(true, true);
+    m_pollTimer.start(m_pollIntervalSec * 1000);
+}
+
+/**
+ * 长时间没有数据，视为连接已失效
+ */
+void ChangeFeed::onWatchdogTimeout()
+{
+    if (m_stream) {
+        qDebug() << "[DEBUG] ChangeFeed: stream idle for too long, reconnecting";
+        m_stream->abort();
+    }
+}
+
+/**
+ * 处理一个完整的事件
+ * 事件数据格式：{"entity": "user|role", "action": "created|updated|deleted", "id": 1}，
+ * 事件类型也可直接使用user/role
+ */
+void ChangeFeed::handleEvent(const QByteArray &type, const QByteArray &data)
+{
+    QJsonObject event = QJsonDocument::fromJson(data).object();
+    QString entity = event["entity"].toString();
+    if (entity.isEmpty()) {
+        entity = QString::fromUtf8(type);
+    }
+    QString action = event["action"].toString();
+    int id = event["id"].toInt();
+    
+    qDebug() << "[DEBUG] ChangeFeed: event" << entity << action << id;
+    
+    EntityStore *store = m_apiManager->entityStore();
+    if (entity == "user") {
+        if (action == "deleted" && id > 0) {
+            store->mergeUsers(QList<UserInfo>(), QList<int>() << id, store->usersWatermark());
+        } else {
+            scheduleSync(true, false);
+        }
+    } else if (entity == "role") {
+        if (action == "deleted" && id > 0) {
+            store->mergeRoles(QList<RoleInfo>(), QList<int>() << id, store->rolesWatermark());
+        } else {
+            scheduleSync(false, true);
+        }
+        // 角色变化会反映在用户的角色列表上
+        scheduleSync(true, false);
+    }
+}
+
+/**
+ * 合并短时间内的多个事件
+ */
+void ChangeFeed::scheduleSync(bool users, bool roles)
+{
+    m_syncUsersPending = m_syncUsersPending || users;
+    m_syncRolesPending = m_syncRolesPending || roles;
+    if (!m_syncTimer.isActive()) {
+        m_syncTimer.start();
+    }
+}
+
+/**
+ * 执行合并后的增量同步
+ */
+void ChangeFeed::onSyncTimeout()
+{
+    if (!m_running || !m_apiManager->isAuthenticated()) {
+        m_syncUsersPending = false;
+        m_syncRolesPending = false;
+        return;
+    }
+    
+    if (m_syncUsersPending) {
+        m_apiManager->syncUsers();
+    }
+    if (m_syncRolesPending) {
+        m_apiManager->syncRoles();
+    }
+    m_syncUsersPending = false;
+    m_syncRolesPending = false;
+}
+
+/**
+ * 本地存储有变化，轮询间隔保持较短
+ */
+void ChangeFeed::onStoreChanged()
+{
+    m_changedSincePoll = true;
+}
+
+/**
+ * 更新推送状态
+ */
+void ChangeFeed::setPushActive(bool active)
+{
+    if (m_pushActive != active) {
+        m_pushActive = active;
+        emit modeChanged(active);
+    }
+}
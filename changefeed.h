@@ -0,0 +1,107 @@
+#ifndef CHANGEFEED_H
+#define CHANGEFEED_H
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+#include "apimanager.h"
+
+/**
+ * 实体变更推送通道
+ * 通过Server-Sent Events订阅服务器的用户/角色变更事件，收到事件后做一次增量同步，
+ * 页面通过EntityStore的变更信号刷新。连接断开时按指数退避重连，
+ * 服务端不支持推送或多次重连失败时改为自适应轮询，并定期尝试恢复推送
+ */
+class ChangeFeed : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChangeFeed(ApiManager *apiManager, QObject *parent = nullptr);
+    ~ChangeFeed();
+    
+    /**
+     * 开始接收变更（已登录后调用）
+     */
+    void start();
+    
+    /**
+     * 停止接收变更（登出或令牌过期时调用）
+     */
+    void stop();
+    
+    /**
+     * 当前是否通过推送接收变更
+     */
+    bool isPushActive() const { return m_pushActive; }
+
+signals:
+    // 推送与轮询模式切换
+    void modeChanged(bool pushActive);
+
+private slots:
+    void onStreamReadyRead();
+    void onStreamFinished();
+    void onReconnectTimeout();
+    void onPollTimeout();
+    void onWatchdogTimeout();
+    void onSyncTimeout();
+    void onStoreChanged();
+    void onTokenRefreshed();
+
+private:
+    ApiManager *m_apiManager;
+    QNetworkAccessManager *m_networkManager;
+    QPointer<QNetworkReply> m_stream;
+    QByteArray m_buffer;
+    QByteArray m_lastEventId;
+    QString m_streamToken;          // 建立事件流时使用的令牌
+    
+    bool m_running;
+    bool m_awaitingToken;           // 事件流因令牌失效断开，等待刷新后重连
+    bool m_pushActive;
+    bool m_pushSupported;
+    int m_failures;
+    int m_reconnectDelayMs;
+    
+    // 重连、轮询、心跳检测与同步合并定时器
+    QTimer m_reconnectTimer;
+    QTimer m_pollTimer;
+    QTimer m_watchdogTimer;
+    QTimer m_syncTimer;
+    
+    // 轮询间隔（秒），本轮无变化时逐步拉长
+    int m_pollIntervalSec;
+    int m_minPollIntervalSec;
+    int m_maxPollIntervalSec;
+    bool m_changedSincePoll;
+    
+    // 待同步的实体
+    bool m_syncUsersPending;
+    bool m_syncRolesPending;
+    
+    // 建立事件流连接
+    void connectStream();
+    
+    // 断开事件流连接
+    void closeStream();
+    
+    // 按退避时间安排重连
+    void scheduleReconnect();
+    
+    // 切换到轮询模式
+    void startPolling();
+    
+    // 更新推送状态
+    void setPushActive(bool active);
+    
+    // 处理一个完整的事件
+    void handleEvent(const QByteArray &type, const QByteArray &data);
+    
+    // 合并短时间内的多个事件，只同步一次
+    void scheduleSync(bool users, bool roles);
+};
+
+#endif // CHANGEFEED_H
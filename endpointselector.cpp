@@ -0,0 +1,294 @@
+#include "endpointselector.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+
+namespace {
+
+// 单次探测超时
+const int ProbeTimeoutMs = 5000;
+
+// 延迟平滑系数
+const double LatencySmoothing = 0.3;
+
+// 未登录时，当前节点延迟超过最快节点的该倍数才重新选择，避免频繁切换
+const double RebalanceFactor = 2.0;
+
+}
+
+/**
+ * 节点选择器构造函数
+ */
+EndpointSelector::EndpointSelector(QObject *parent)
+    : QObject(parent)
+    , m_networkManager(new QNetworkAccessManager(this))
+    , m_active(-1)
+    , m_sticky(false)
+    , m_initialSelection(false)
+{
+    m_probeTimer.setInterval(30 * 1000);
+    connect(&m_probeTimer, &QTimer::timeout, this, &EndpointSelector::probeAll);
+}
+
+/**
+ * 设置节点列表
+ */
+void EndpointSelector::setEndpoints(const QStringList &baseUrls)
+{
+    // 先清空列表再中止进行中的探测，中止触发的finished不再被处理
+    const QList<Endpoint> previous = m_endpoints;
+    m_endpoints.clear();
+    for (const Endpoint &endpoint : previous) {
+        if (endpoint.probe) {
+            endpoint.probe->abort();
+        }
+    }
+    
+    for (const QString &baseUrl : baseUrls) {
+        QString url = baseUrl.trimmed();
+        while (url.endsWith('/')) {
+            url.chop(1);
+        }
+        bool duplicate = false;
+        for (const Endpoint &endpoint : m_endpoints) {
+            duplicate = duplicate || endpoint.baseUrl == url;
+        }
+        if (!url.isEmpty() && !duplicate) {
+            Endpoint endpoint;
+            endpoint.baseUrl = url;
+            m_endpoints.append(endpoint);
+        }
+    }
+    
+    m_active = m_endpoints.isEmpty() ? -1 : 0;
+    m_initialSelection = true;
+    
+    if (m_endpoints.size() > 1) {
+        qDebug() << "[DEBUG] EndpointSelector: probing" << m_endpoints.size() << "endpoints";
+        m_probeTimer.start();
+        probeAll();
+    } else {
+        m_probeTimer.stop();
+    }
+}
+
+/**
+ * 当前使用的节点基础地址
+ */
+QString EndpointSelector::active() const
+{
+    return m_active >= 0 ? m_endpoints[m_active].baseUrl : QString();
+}
+
+/**
+ * 设置探测间隔
+ */
+void EndpointSelector::setProbeInterval(int seconds)
+{
+    m_probeTimer.setInterval(qMax(5, seconds) * 1000);
+}
+
+/**
+ * 设置是否固定当前节点
+ */
+void EndpointSelector::setSticky(bool sticky)
+{
+    m_sticky = sticky;
+}
+
+/**
+ * 报告请求的连接失败
+ */
+void EndpointSelector::reportFailure(const QUrl &url)
+{
+    int index = indexOf(url);
+    if (index < 0 || index != m_active || m_endpoints.size() < 2) {
+        return;
+    }
+    
+    qDebug() << "[DEBUG] EndpointSelector: connection failure on" << m_endpoints[index].baseUrl;
+    m_endpoints[index].healthy = false;
+    select(true);
+}
+
+/**
+ * 将请求地址改写到当前节点
+ */
+QUrl EndpointSelector::rebase(const QUrl &url) const
+{
+    int index = indexOf(url);
+    if (index < 0 || index == m_active) {
+        return url;
+    }
+    
+    QString encoded = QString::fromUtf8(url.toEncoded());
+    return QUrl::fromEncoded((active() + encoded.mid(m_endpoints[index].baseUrl.size())).toUtf8());
+}
+
+/**
+ * 探测所有节点
+ */
+void EndpointSelector::probeAll()
+{
+    for (int i = 0; i < m_endpoints.size(); ++i) {
+        if (m_endpoints[i].probe) {
+            continue;
+        }
+        
+        QNetworkRequest request(healthUrl(m_endpoints[i].baseUrl));
+        request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+        QNetworkReply *reply = m_networkManager->get(request);
+        m_endpoints[i].probe = reply;
+        
+        qint64 startedAt = QDateTime::currentMSecsSinceEpoch();
+        QTimer::singleShot(ProbeTimeoutMs, reply, [reply]() {
+            reply->abort();
+        });
+        connect(reply, &QNetworkReply::finished, this, [this, i, reply, startedAt]() {
+            onProbeFinished(i, reply, startedAt);
+        });
+    }
+}
+
+/**
+ * 处理探测结果
+ */
+void EndpointSelector::onProbeFinished(int index, QNetworkReply *reply, qint64 startedAt)
+{
+    reply->deleteLater();
+    if (index >= m_endpoints.size() || m_endpoints[index].probe != reply) {
+        return;
+    }
+    
+    Endpoint &endpoint = m_endpoints[index];
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    bool healthy = (reply->error() == QNetworkReply::NoError && statusCode >= 200 && statusCode < 300);
+    double latency = double(QDateTime::currentMSecsSinceEpoch() - startedAt);
+    
+    if (healthy) {
+        endpoint.latencyMs = endpoint.probed ? endpoint.latencyMs + (latency - endpoint.latencyMs) * LatencySmoothing
+                                             : latency;
+    }
+    if (healthy != endpoint.healthy) {
+        qDebug() << "[DEBUG] EndpointSelector:" << endpoint.baseUrl << (healthy ? "is healthy" : "is unhealthy");
+    }
+    endpoint.healthy = healthy;
+    endpoint.probed = true;
+    
+    // 一轮探测全部返回后再选择，避免只根据最先返回的节点做决定
+    for (const Endpoint &other : m_endpoints) {
+        if (other.probe && other.probe != reply) {
+            return;
+        }
+    }
+    select(false);
+}
+
+/**
+ * 查找请求地址所属的节点
+ */
+int EndpointSelector::indexOf(const QUrl &url) const
+{
+    QString encoded = QString::fromUtf8(url.toEncoded());
+    for (int i = 0; i < m_endpoints.size(); ++i) {
+        const QString &baseUrl = m_endpoints[i].baseUrl;
+        if (encoded.startsWith(baseUrl)
+            && (encoded.size() == baseUrl.size() || encoded[baseUrl.size()] == '/' || encoded[baseUrl.size()] == '?')) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 选择节点
+ * 当前节点不健康时必须切换（force）；未登录时在首轮探测后或当前节点明显变慢时重新选择；
+ * 候选节点按延迟倒数加权随机选择，多个客户端的负载自然分散到较快的节点；
+ * 没有已探测的健康节点时，强制切换在未探测的节点中等概率选择
+ */
+void EndpointSelector::select(bool force)
+{
+    if (m_active < 0) {
+        return;
+    }
+    
+    const Endpoint &current = m_endpoints[m_active];
+    double fastest = 0.0;
+    QList<int> candidates;
+    for (int i = 0; i < m_endpoints.size(); ++i) {
+        if (m_endpoints[i].healthy && m_endpoints[i].probed) {
+            candidates.append(i);
+            if (fastest <= 0.0 || m_endpoints[i].latencyMs < fastest) {
+                fastest = m_endpoints[i].latencyMs;
+            }
+        }
+    }
+    
+    bool reselect = force || !current.healthy;
+    if (!reselect && !m_sticky) {
+        reselect = m_initialSelection || (current.probed && current.latencyMs > fastest * RebalanceFactor);
+    }
+    m_initialSelection = false;
+    if (!reselect) {
+        return;
+    }
+    
+    // 切换时不再选择故障节点
+    if (!current.healthy) {
+        candidates.removeAll(m_active);
+    }
+    
+    // 其他节点还没有探测结果（如首轮探测尚未完成）时，强制切换退而选择未探测的节点
+    if (candidates.isEmpty() && force) {
+        for (int i = 0; i < m_endpoints.size(); ++i) {
+            if (i != m_active && m_endpoints[i].healthy && !m_endpoints[i].probed) {
+                candidates.append(i);
+            }
+        }
+    }
+    if (candidates.isEmpty()) {
+        return;
+    }
+    
+    double total = 0.0;
+    for (int i : candidates) {
+        total += 1.0 / qMax(1.0, m_endpoints[i].latencyMs);
+    }
+    double pick = QRandomGenerator::global()->generateDouble() * total;
+    int chosen = candidates.last();
+    for (int i : candidates) {
+        pick -= 1.0 / qMax(1.0, m_endpoints[i].latencyMs);
+        if (pick <= 0.0) {
+            chosen = i;
+            break;
+        }
+    }
+    activate(chosen);
+}
+
+/**
+ * 切换当前节点
+ */
+void EndpointSelector::activate(int index)
+{
+    if (index == m_active) {
+        return;
+    }
+    
+    qDebug() << "[DEBUG] EndpointSelector: switching from" << active() << "to" << m_endpoints[index].baseUrl
+             << "latency:" << m_endpoints[index].latencyMs << "ms";
+    m_active = index;
+    emit activeChanged(m_endpoints[index].baseUrl);
+}
+
+/**
+ * 节点的健康检查地址（位于服务器根路径，不在API前缀下）
+ */
+QUrl EndpointSelector::healthUrl(const QString &baseUrl)
+{
+    QUrl url(baseUrl);
+    url.setPath("/health");
+    url.setQuery(QString());
+    return url;
+}
@@ -0,0 +1,85 @@
+#ifndef ENDPOINTSELECTOR_H
+#define ENDPOINTSELECTOR_H
+
+#include <QObject>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * 后端节点选择
+ * 配置了多个API基础地址时定期探测各节点的/health，记录延迟与健康状态；
+ * 按延迟加权选择节点，当前节点连接失败或探测失败时切换到其他健康节点。
+ * 登录后固定使用当前节点（粘滞），只在故障时切换，避免会话在节点之间来回迁移
+ */
+class EndpointSelector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EndpointSelector(QObject *parent = nullptr);
+    
+    /**
+     * 设置节点列表，第一个为首选节点并立即生效；多于一个节点时开始定期探测
+     */
+    void setEndpoints(const QStringList &baseUrls);
+    
+    /**
+     * 当前使用的节点基础地址
+     */
+    QString active() const;
+    
+    /**
+     * 设置探测间隔（秒）
+     */
+    void setProbeInterval(int seconds);
+    
+    /**
+     * 设置是否固定当前节点（已登录时为true）
+     */
+    void setSticky(bool sticky);
+    
+    /**
+     * 报告请求的连接失败，url属于当前节点时将其标记为不健康并切换
+     */
+    void reportFailure(const QUrl &url);
+    
+    /**
+     * 将属于某个节点的请求地址改写到当前节点，不属于任何节点时原样返回
+     */
+    QUrl rebase(const QUrl &url) const;
+
+signals:
+    // 当前节点变化
+    void activeChanged(const QString &baseUrl);
+
+private slots:
+    void probeAll();
+
+private:
+    struct Endpoint {
+        QString baseUrl;
+        bool healthy = true;
+        bool probed = false;
+        double latencyMs = 0.0;
+        QPointer<QNetworkReply> probe;
+    };
+    
+    void onProbeFinished(int index, QNetworkReply *reply, qint64 startedAt);
+    int indexOf(const QUrl &url) const;
+    void select(bool force);
+    void activate(int index);
+    static QUrl healthUrl(const QString &baseUrl);
+    
+    QNetworkAccessManager *m_networkManager;
+    QList<Endpoint> m_endpoints;
+    int m_active;
+    bool m_sticky;
+    bool m_initialSelection;
+    QTimer m_probeTimer;
+};
+
+#endif // ENDPOINTSELECTOR_H
@@ -0,0 +1,401 @@
+#include "entitystore.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+
+namespace {
+
+// 快照文件标识与格式版本，格式变化时递增版本号，旧快照直接丢弃
+const quint32 SnapshotMagic = 0x44424153; // "DBAS"
+const quint16 SnapshotVersion = 3;
+
+}
+
+/**
+ * 实体序列化
+ */
+static QDataStream &operator<<(QDataStream &out, const UserInfo &user)
+{
+    out << qint32(user.id) << user.username << user.email << user.fullName
+        << user.isActive << user.isSuperuser << user.createdAt << user.updatedAt << user.lastLogin << user.roles;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, UserInfo &user)
+{
+    qint32 id;
+    in >> id >> user.username >> user.email >> user.fullName
+       >> user.isActive >> user.isSuperuser >> user.createdAt >> user.updatedAt >> user.lastLogin >> user.roles;
+    user.id = id;
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const PermissionInfo &permission)
+{
+    out << qint32(permission.id) << permission.name << permission.displayName
+        << permission.description << permission.resource << permission.action;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, PermissionInfo &permission)
+{
+    qint32 id;
+    in >> id >> permission.name >> permission.displayName
+       >> permission.description >> permission.resource >> permission.action;
+    permission.id = id;
+    return in;
+}
+
+static QDataStream &operator<<(QDataStream &out, const RoleInfo &role)
+{
+    out << qint32(role.id) << role.name << role.displayName << role.description
+        << role.isActive << role.createdAt << role.updatedAt << qint32(role.permissionCount)
+        << qint32(role.permissions.size());
+    for (const PermissionInfo &permission : role.permissions) {
+        out << permission;
+    }
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, RoleInfo &role)
+{
+    qint32 id;
+    qint32 permissionCount;
+    qint32 permissionListSize;
+    in >> id >> role.name >> role.displayName >> role.description
+       >> role.isActive >> role.createdAt >> role.updatedAt >> permissionCount >> permissionListSize;
+    role.id = id;
+    role.permissionCount = permissionCount;
+    role.permissions.clear();
+    for (qint32 i = 0; i < permissionListSize && in.status() == QDataStream::Ok; ++i) {
+        PermissionInfo permission;
+        in >> permission;
+        role.permissions.append(permission);
+    }
+    return in;
+}
+
+template<typename T>
+static void writeList(QDataStream &out, const QList<T> &items)
+{
+    out << qint32(items.size());
+    for (const T &item : items) {
+        out << item;
+    }
+}
+
+template<typename T>
+static QList<T> readList(QDataStream &in)
+{
+    QList<T> items;
+    qint32 count = 0;
+    in >> count;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        T item;
+        in >> item;
+        items.append(item);
+    }
+    return items;
+}
+
+/**
+ * 按ID合并记录，结果按ID排序
+ */
+template<typename T>
+static void mergeById(QList<T> &items, const QList<T> &changed, const QList<int> &deletedIds)
+{
+    QHash<int, int> indexById;
+    for (int i = 0; i < items.size(); ++i) {
+        indexById.insert(items[i].id, i);
+    }
+    
+    for (const T &item : changed) {
+        auto found = indexById.constFind(item.id);
+        if (found != indexById.constEnd()) {
+            items[found.value()] = item;
+        } else {
+            indexById.insert(item.id, items.size());
+            items.append(item);
+        }
+    }
+    
+    if (!deletedIds.isEmpty()) {
+        QSet<int> deleted;
+        for (int id : deletedIds) {
+            deleted.insert(id);
+        }
+        items.erase(std::remove_if(items.begin(), items.end(), [&deleted](const T &item) {
+            return deleted.contains(item.id);
+        }), items.end());
+    }
+    
+    std::sort(items.begin(), items.end(), [](const T &a, const T &b) {
+        return a.id < b.id;
+    });
+}
+
+/**
+ * 实体存储构造函数
+ */
+EntityStore::EntityStore(QObject *parent)
+    : QObject(parent)
+{
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(1000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &EntityStore::saveSnapshot);
+}
+
+/**
+ * 析构时写入尚未保存的更新
+ */
+EntityStore::~EntityStore()
+{
+    if (m_saveTimer.isActive()) {
+        m_saveTimer.stop();
+        saveSnapshot();
+    }
+}
+
+/**
+ * 打开指定服务器与用户的快照
+ */
+bool EntityStore::openSnapshot(const QString &baseUrl, const QString &username)
+{
+    // 切换前先保存当前快照
+    if (m_saveTimer.isActive()) {
+        m_saveTimer.stop();
+        saveSnapshot();
+    }
+    
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/snapshots";
+    QByteArray scope = QCryptographicHash::hash((baseUrl + '\n' + username).toUtf8(),
+                                                QCryptographicHash::Sha1).toHex();
+    m_baseUrl = baseUrl;
+    m_snapshotPath = dir + "/" + QString::fromLatin1(scope) + ".snapshot";
+    m_snapshotTime = QDateTime();
+    m_users.clear();
+    m_roles.clear();
+    m_permissions.clear();
+    m_usersWatermark.clear();
+    m_rolesWatermark.clear();
+    
+    return loadSnapshot();
+}
+
+/**
+ * 读取快照文件
+ * 文件通过内存映射读取，避免整体复制到内存
+ */
+bool EntityStore::loadSnapshot()
+{
+    QFile file(m_snapshotPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    qint64 size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data) {
+        qDebug() << "[DEBUG] EntityStore: failed to map snapshot" << m_snapshotPath << file.errorString();
+        return false;
+    }
+    
+    QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_12);
+    
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString baseUrl;
+    qint64 savedAt = 0;
+    QString usersWatermark;
+    QString rolesWatermark;
+    in >> magic >> version;
+    bool valid = (magic == SnapshotMagic && version == SnapshotVersion);
+    if (valid) {
+        in >> baseUrl >> savedAt >> usersWatermark >> rolesWatermark;
+        QList<UserInfo> users = readList<UserInfo>(in);
+        QList<RoleInfo> roles = readList<RoleInfo>(in);
+        QList<PermissionInfo> permissions = readList<PermissionInfo>(in);
+        valid = (in.status() == QDataStream::Ok && baseUrl == m_baseUrl);
+        if (valid) {
+            m_users = users;
+            m_roles = roles;
+            m_permissions = permissions;
+            m_usersWatermark = usersWatermark;
+            m_rolesWatermark = rolesWatermark;
+            m_snapshotTime = QDateTime::fromMSecsSinceEpoch(savedAt);
+        }
+    }
+    
+    file.unmap(data);
+    
+    if (!valid) {
+        qDebug() << "[DEBUG] EntityStore: ignoring invalid snapshot" << m_snapshotPath;
+        return false;
+    }
+    
+    qDebug() << "[DEBUG] EntityStore: loaded snapshot from" << m_snapshotTime.toString(Qt::ISODate)
+             << "users:" << m_users.size() << "roles:" << m_roles.size()
+             << "permissions:" << m_permissions.size();
+    return true;
+}
+
+/**
+ * 写入快照文件
+ * 先写临时文件再替换，写入中断不会损坏已有快照；快照包含用户目录，只允许当前用户读写
+ */
+void EntityStore::saveSnapshot()
+{
+    if (m_snapshotPath.isEmpty()) {
+        return;
+    }
+    
+    QDir().mkpath(QFileInfo(m_snapshotPath).absolutePath());
+    
+    QSaveFile file(m_snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "[DEBUG] EntityStore: failed to write snapshot" << m_snapshotPath << file.errorString();
+        return;
+    }
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    
+    QDateTime savedAt = QDateTime::currentDateTime();
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << SnapshotMagic << SnapshotVersion << m_baseUrl << savedAt.toMSecsSinceEpoch()
+        << m_usersWatermark << m_rolesWatermark;
+    writeList(out, m_users);
+    writeList(out, m_roles);
+    writeList(out, m_permissions);
+    
+    if (file.commit()) {
+        m_snapshotTime = savedAt;
+    } else {
+        qDebug() << "[DEBUG] EntityStore: failed to commit snapshot" << file.errorString();
+    }
+}
+
+/**
+ * 计划写入快照
+ */
+void EntityStore::scheduleSave()
+{
+    if (!m_snapshotPath.isEmpty()) {
+        m_saveTimer.start();
+    }
+}
+
+/**
+ * 取两个updated_at水位中较晚的一个
+ * 按ISO 8601时间比较：小数秒位数或时区写法不同时按字符串比较会排错顺序；
+ * 无法解析的水位视为最早，两个都无法解析时按字符串比较
+ */
+QString EntityStore::laterWatermark(const QString &first, const QString &second)
+{
+    QDateTime firstTime = QDateTime::fromString(first, Qt::ISODateWithMs);
+    QDateTime secondTime = QDateTime::fromString(second, Qt::ISODateWithMs);
+    if (!firstTime.isValid() && !secondTime.isValid()) {
+        return qMax(first, second);
+    }
+    if (!secondTime.isValid()) {
+        return first;
+    }
+    if (!firstTime.isValid()) {
+        return second;
+    }
+    if (firstTime == secondTime) {
+        // 毫秒以下的差别按字符串区分
+        return qMax(first, second);
+    }
+    return secondTime > firstTime ? second : first;
+}
+
+/**
+ * 更新用户列表
+ */
+void EntityStore::setUsers(const QList<UserInfo> &users, const QString &watermark)
+{
+    m_users = users;
+    m_usersWatermark = watermark;
+    scheduleSave();
+    emit usersChanged();
+}
+
+/**
+ * 更新角色列表
+ */
+void EntityStore::setRoles(const QList<RoleInfo> &roles, const QString &watermark)
+{
+    m_roles = roles;
+    m_rolesWatermark = watermark;
+    scheduleSave();
+    emit rolesChanged();
+}
+
+/**
+ * 合并用户增量
+ */
+void EntityStore::mergeUsers(const QList<UserInfo> &changed, const QList<int> &deletedIds, const QString &watermark)
+{
+    m_usersWatermark = laterWatermark(m_usersWatermark, watermark);
+    if (changed.isEmpty() && deletedIds.isEmpty()) {
+        scheduleSave();
+        return;
+    }
+    
+    mergeById(m_users, changed, deletedIds);
+    scheduleSave();
+    emit usersChanged();
+}
+
+/**
+ * 合并角色增量
+ */
+void EntityStore::mergeRoles(const QList<RoleInfo> &changed, const QList<int> &deletedIds, const QString &watermark)
+{
+    m_rolesWatermark = laterWatermark(m_rolesWatermark, watermark);
+    if (changed.isEmpty() && deletedIds.isEmpty()) {
+        scheduleSave();
+        return;
+    }
+    
+    mergeById(m_roles, changed, deletedIds);
+    scheduleSave();
+    emit rolesChanged();
+}
+
+/**
+ * 更新权限列表
+ */
+void EntityStore::setPermissions(const QList<PermissionInfo> &permissions)
+{
+    m_permissions = permissions;
+    scheduleSave();
+    emit permissionsChanged();
+}
+
+/**
+ * 清空数据并删除快照文件
+ */
+void EntityStore::clear()
+{
+    m_saveTimer.stop();
+    m_users.clear();
+    m_roles.clear();
+    m_permissions.clear();
+    m_usersWatermark.clear();
+    m_rolesWatermark.clear();
+    m_snapshotTime = QDateTime();
+    if (!m_snapshotPath.isEmpty()) {
+        QFile::remove(m_snapshotPath);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QDateTime>
+#include <QTimer>
+#include "apimanager.h"
+
+/**
+ * 本地实体存储
+ * 保存最近一次从服务器获取的用户、角色和权限列表，并持久化为二进制快照文件。
+ * 启动时通过内存映射读取快照，页面可先显示快照数据，再在后台与服务器同步
+ */
+class EntityStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EntityStore(QObject *parent = nullptr);
+    ~EntityStore();
+    
+    /**
+     * 打开指定服务器与用户的快照，不同服务器、不同用户使用不同的快照文件
+     */
+    bool openSnapshot(const QString &baseUrl, const QString &username);
+    
+    /**
+     * 是否已有快照数据
+     */
+    bool hasSnapshot() const { return m_snapshotTime.isValid(); }
+    
+    /**
+     * 快照保存时间
+     */
+    QDateTime snapshotTime() const { return m_snapshotTime; }
+    
+    /**
+     * 实体数据
+     */
+    const QList<UserInfo> &users() const { return m_users; }
+    const QList<RoleInfo> &roles() const { return m_roles; }
+    const QList<PermissionInfo> &permissions() const { return m_permissions; }
+    
+    /**
+     * 增量同步高水位（已同步记录中最大的updated_at），为空表示需要全量同步
+     */
+    QString usersWatermark() const { return m_usersWatermark; }
+    QString rolesWatermark() const { return m_rolesWatermark; }
+    
+    /**
+     * 取两个updated_at水位中较晚的一个（按时间比较，返回原字符串）
+     */
+    static QString laterWatermark(const QString &first, const QString &second);
+    
+    /**
+     * 用服务器返回的完整数据替换存储，稍后写入快照
+     */
+    void setUsers(const QList<UserInfo> &users, const QString &watermark = QString());
+    void setRoles(const QList<RoleInfo> &roles, const QString &watermark = QString());
+    void setPermissions(const QList<PermissionInfo> &permissions);
+    
+    /**
+     * 合并增量同步结果：按ID更新或插入变化的记录，移除已删除的记录，水位只前进不后退
+     */
+    void mergeUsers(const QList<UserInfo> &changed, const QList<int> &deletedIds, const QString &watermark);
+    void mergeRoles(const QList<RoleInfo> &changed, const QList<int> &deletedIds, const QString &watermark);
+    
+    /**
+     * 清空数据并删除快照文件
+     */
+    void clear();
+
+signals:
+    void usersChanged();
+    void rolesChanged();
+    void permissionsChanged();
+
+private slots:
+    /**
+     * 写入快照文件
+     */
+    void saveSnapshot();
+
+private:
+    QString m_baseUrl;
+    QString m_snapshotPath;
+    QDateTime m_snapshotTime;
+    QList<UserInfo> m_users;
+    QList<RoleInfo> m_roles;
+    QList<PermissionInfo> m_permissions;
+    QString m_usersWatermark;
+    QString m_rolesWatermark;
+    
+    // 合并短时间内的多次更新，只写一次文件
+    QTimer m_saveTimer;
+    
+    // 读取快照文件
+    bool loadSnapshot();
+    
+    // 计划写入快照
+    void scheduleSave();
+};
+
+#endif // ENTITYSTORE_H
@@ -0,0 +1,68 @@
+#ifndef ITOOL_H
+#define ITOOL_H
+
+#include <QtPlugin>
+#include <QString>
+#include <QUrl>
+
+QT_BEGIN_NAMESPACE
+class QWidget;
+QT_END_NAMESPACE
+
+/**
+ * 工具插件接口
+ * 插件以共享库形式放在 plugins/tools 目录下，通过
+ * Q_PLUGIN_METADATA(IID ITool_iid FILE "tool.json") 声明元数据，
+ * 元数据至少包含 id 和 name 字段，主窗口据此生成菜单项，
+ * 插件库本身只在工具首次打开时才会被加载
+ */
+class ITool
+{
+public:
+    virtual ~ITool() = default;
+    
+    /**
+     * 设置服务器上下文（API地址与认证令牌）
+     * 创建页面前调用一次，之后令牌在后台刷新时会以新令牌再次调用
+     */
+    virtual void setServerContext(const QUrl &baseUrl, const QString &authToken)
+    {
+        Q_UNUSED(baseUrl)
+        Q_UNUSED(authToken)
+    }
+    
+    /**
+     * 创建工具页面
+     */
+    virtual QWidget *createWidget(QWidget *parent) = 0;
+};
+
+/**
+ * 工具页面激活/停用回调
+ * 工具页面常驻在主窗口的页面栈中，切换时不会被销毁；
+ * 页面可实现此接口（并声明Q_INTERFACES(IToolPage)）以在切入/切出时
+ * 加载数据或暂停后台工作
+ */
+class IToolPage
+{
+public:
+    virtual ~IToolPage() = default;
+    
+    /**
+     * 页面切换为当前工具时调用
+     */
+    virtual void activateTool() {}
+    
+    /**
+     * 页面从当前工具切走时调用
+     */
+    virtual void deactivateTool() {}
+};
+
+#define ITool_iid "com.redgreat.dbatools.ITool/1.0"
+#define IToolPage_iid "com.redgreat.dbatools.IToolPage/1.0"
+
+Q_DECLARE_INTERFACE(ITool, ITool_iid)
+Q_DECLARE_INTERFACE(IToolPage, IToolPage_iid)
+
+#endif // ITOOL_H
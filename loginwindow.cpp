@@ -12,7 +12,7 @@ MainWindow *LoginWindow::s_mainWindow = nullptr;
  * 登录窗口构造函数
  * 初始化UI组件和API管理器
  */
-LoginWindow::LoginWindow(QWidget *parent)
+LoginWindow::LoginWindow(ApiManager *apiManager, QWidget *parent)
     : QMainWindow(parent)
     , m_centralWidget(nullptr)
     , m_usernameEdit(nullptr)
@@ -25,21 +25,26 @@ LoginWindow::LoginWindow(QWidget *parent)
     , m_statusLabel(nullptr)
     , m_progressBar(nullptr)
     , m_rememberPasswordCheckBox(nullptr)
-    , m_apiManager(new ApiManager(this))
+    , m_apiManager(apiManager)
     , m_settings(new QSettings(this))
 {
     setupUI();
     setupStyles();
     
-    // 连接API管理器信号
-    connect(m_apiManager, &ApiManager::loginResult,
-            this, &LoginWindow::onLoginResult);
-    connect(m_apiManager, &ApiManager::networkError,
-            this, &LoginWindow::onNetworkError);
+    if (m_apiManager) {
+        // 接管启动时验证失败的会话所用的API管理器，丢弃其中的旧令牌与凭据
+        m_apiManager->setParent(this);
+        m_apiManager->setAuthToken(QString());
+        m_apiManager->setCredentials(QString(), QString());
+    } else {
+        // 从设置中加载服务器URL
+        m_apiManager = new ApiManager(this);
+        QString serverUrl = m_settings->value("server/url", "http://localhost:8001/api").toString();
+        m_apiManager->setBaseUrl(serverUrl);
+    }
     
-    // 从设置中加载服务器URL
-    QString serverUrl = m_settings->value("server/url", "http://localhost:8001/api").toString();
-    m_apiManager->setBaseUrl(serverUrl);
+    // 用户输入账号密码期间提前建立连接（已建立的连接直接复用）
+    m_apiManager->warmUp();
     
     // 加载保存的登录信息
     loadSavedCredentials();
@@ -272,19 +277,20 @@ void LoginWindow::onLoginClicked()
     qDebug() << "[DEBUG] About to call ApiManager::login with username:" << username;
     qDebug() << "[DEBUG] Password length:" << password.length();
     
-    m_apiManager->login(username, password);
+    m_apiManager->login(username, password)->then(this, [this](ApiReply *reply) {
+        onLoginResult(reply);
+    });
     qDebug() << "[DEBUG] ApiManager::login called";
 }
 
 /**
  * 处理登录结果
  */
-void LoginWindow::onLoginResult(bool success, const QString &message, const QString &token)
+void LoginWindow::onLoginResult(ApiReply *reply)
 {
-    qDebug() << "[DEBUG] LoginWindow::onLoginResult called with:";
-    qDebug() << "[DEBUG]   success:" << success;
-    qDebug() << "[DEBUG]   message:" << message;
-    qDebug() << "[DEBUG]   token:" << token;
+    bool success = reply->isSuccess();
+    QString token = reply->value<QString>();
+    qDebug() << "[DEBUG] LoginWindow::onLoginResult called with success:" << success;
     
     setLoginState(false);
     qDebug() << "[DEBUG] Login state set to false";
@@ -299,19 +305,18 @@ void LoginWindow::onLoginResult(bool success, const QString &message, const QStr
         m_settings->setValue("auth/username", m_usernameEdit->text());
         qDebug() << "[DEBUG] Auth token and username saved";
         
-        // 如果选择了记住密码，则保存凭据
-        if (m_rememberPasswordCheckBox->isChecked()) {
-            saveCredentials();
-        }
+        // 保存凭据；未选择记住密码时清除之前记住的密码，下次启动不再自动恢复会话
+        saveCredentials();
         
-        // 延迟一下再打开主窗口
-        QTimer::singleShot(500, this, [this]() {
+        // 回到事件循环后立即打开主窗口
+        QTimer::singleShot(0, this, [this]() {
             qDebug() << "[DEBUG] About to open main window and close login window";
             
             // 检查是否已存在MainWindow实例
             qDebug() << "[DEBUG] Current s_mainWindow value:" << s_mainWindow;
             if (s_mainWindow == nullptr) {
-                s_mainWindow = new MainWindow();
+                // 登录用的API管理器（已持有新令牌与预热好的连接）交给主窗口继续使用
+                s_mainWindow = new MainWindow(m_apiManager);
                 qDebug() << "[DEBUG] Created new MainWindow instance:" << s_mainWindow;
             } else {
                 qDebug() << "[DEBUG] MainWindow already exists, reusing instance:" << s_mainWindow;
@@ -324,7 +329,11 @@ void LoginWindow::onLoginResult(bool success, const QString &message, const QStr
         });
     } else {
         qDebug() << "[DEBUG] Login failed, showing error message";
-        m_statusLabel->setText(message.isEmpty() ? "登录失败" : message);
+        if (reply->statusCode() == 0) {
+            m_statusLabel->setText("网络错误: " + reply->error());
+        } else {
+            m_statusLabel->setText(reply->error().isEmpty() ? "登录失败" : reply->error());
+        }
         m_statusLabel->setStyleSheet("QLabel { color: #e74c3c; font-size: 12px; }");
         m_passwordEdit->clear();
         m_passwordEdit->setFocus();
@@ -332,16 +341,6 @@ void LoginWindow::onLoginResult(bool success, const QString &message, const QStr
     qDebug() << "[DEBUG] LoginWindow::onLoginResult completed";
 }
 
-/**
- * 处理网络错误
- */
-void LoginWindow::onNetworkError(const QString &error)
-{
-    setLoginState(false);
-    m_statusLabel->setText("网络错误: " + error);
-    m_statusLabel->setStyleSheet("QLabel { color: #e74c3c; font-size: 12px; }");
-}
-
 /**
  * 服务器设置按钮点击事件
  */
@@ -359,6 +358,7 @@ void LoginWindow::onServerSettingsClicked()
     if (ok && !newUrl.isEmpty()) {
         settings.setValue("server/url", newUrl);
         m_apiManager->setBaseUrl(newUrl);
+        m_apiManager->warmUp();
         m_statusLabel->setText("服务器地址已更新");
         m_statusLabel->setStyleSheet("QLabel { color: #27ae60; font-size: 12px; }");
     }
@@ -426,6 +426,10 @@ void LoginWindow::loadSavedCredentials()
 void LoginWindow::saveCredentials()
 {
     m_settings->setValue("login/username", m_usernameEdit->text());
-    m_settings->setValue("login/password", m_passwordEdit->text());
+    if (m_rememberPasswordCheckBox->isChecked()) {
+        m_settings->setValue("login/password", m_passwordEdit->text());
+    } else {
+        m_settings->remove("login/password");
+    }
     m_settings->setValue("login/remember", m_rememberPasswordCheckBox->isChecked());
 }
\ No newline at end of file
@@ -26,7 +26,8 @@ class LoginWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    LoginWindow(QWidget *parent = nullptr);
+    // apiManager为启动时验证令牌用过的API管理器，登录窗口接管后继续使用其连接；为空时新建
+    LoginWindow(ApiManager *apiManager = nullptr, QWidget *parent = nullptr);
     ~LoginWindow();
     
     // 静态MainWindow实例指针
@@ -37,10 +38,7 @@ private slots:
     void onLoginClicked();
     
     // 处理登录结果
-    void onLoginResult(bool success, const QString &message, const QString &token);
-    
-    // 处理网络错误
-    void onNetworkError(const QString &error);
+    void onLoginResult(ApiReply *reply);
     
     // 服务器设置按钮点击事件
     void onServerSettingsClicked();
@@ -59,7 +57,7 @@ private:
     QProgressBar *m_progressBar;
     QCheckBox *m_rememberPasswordCheckBox;
     
-    // API管理器
+    // API管理器（登录成功后交给主窗口继续使用）
     ApiManager *m_apiManager;
     
     // 设置对象
@@ -1,10 +1,13 @@
 #include <QApplication>
 #include <QIcon>
+#include <QSettings>
+#include <QDebug>
 #include "loginwindow.h"
+#include "mainwindow.h"
 
 /**
  * 应用程序主入口函数
- * 初始化QT应用程序并显示登录窗口
+ * 初始化QT应用程序并显示登录窗口；记住登录且保存的令牌仍有效时直接进入主窗口
  */
 int main(int argc, char *argv[])
 {
@@ -18,9 +21,45 @@ int main(int argc, char *argv[])
     // 设置应用程序图标
     app.setWindowIcon(QIcon(":/icon.svg"));
     
-    // 创建并显示登录窗口
-    LoginWindow loginWindow;
-    loginWindow.show();
+    // 记住登录且已保存令牌时先验证令牌（不重试，限时），通过后直接进入主窗口；
+    // 令牌无效或无法连接服务器时转到登录窗口，不弹出会话过期提示
+    QSettings settings;
+    QString savedToken = settings.value("auth/token").toString();
+    if (settings.value("login/remember", false).toBool() && !savedToken.isEmpty()) {
+        ApiManager *apiManager = new ApiManager();
+        apiManager->setBaseUrl(settings.value("server/url", "http://localhost:8001/api").toString());
+        apiManager->setAuthToken(savedToken);
+        apiManager->setCredentials(settings.value("login/username").toString(),
+                                   settings.value("login/password").toString());
+        int timeoutMs = qMax(1, settings.value("auth/resume_timeout", 5).toInt()) * 1000;
+        apiManager->validateSession(timeoutMs)->then(apiManager, [apiManager](ApiReply *reply) {
+            QSettings settings;
+            if (reply->isSuccess() && apiManager->isAuthenticated()) {
+                UserInfo user = reply->value<UserInfo>();
+                qDebug() << "[DEBUG] Saved session is valid for user:" << user.username;
+                // 验证期间令牌可能已用记住的密码刷新
+                settings.setValue("auth/token", apiManager->getAuthToken());
+                settings.setValue("auth/username", user.username);
+                MainWindow *mainWindow = new MainWindow(apiManager);
+                mainWindow->setAttribute(Qt::WA_DeleteOnClose);
+                mainWindow->show();
+                return;
+            }
+            
+            qDebug() << "[DEBUG] Could not resume saved session:" << reply->statusCode() << reply->error();
+            if (reply->statusCode() == 401) {
+                settings.remove("auth/token");
+            }
+            LoginWindow *loginWindow = new LoginWindow(apiManager);
+            loginWindow->setAttribute(Qt::WA_DeleteOnClose);
+            loginWindow->show();
+        });
+    } else {
+        // 创建并显示登录窗口
+        LoginWindow *loginWindow = new LoginWindow();
+        loginWindow->setAttribute(Qt::WA_DeleteOnClose);
+        loginWindow->show();
+    }
     
     return app.exec();
 }
\ No newline at end of file
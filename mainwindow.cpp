@@ -3,23 +3,33 @@
 #include "usermanager.h"
 #include "rolemanager.h"
 #include "loginwindow.h"
+#include "itool.h"
+#include "entitystore.h"
+#include "changefeed.h"
 #include <QApplication>
 #include <QMessageBox>
 #include <QInputDialog>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
-#include <QShowEvent>
 #include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QLibrary>
+#include <QPluginLoader>
 #include <iostream>
 
 /**
  * 主窗口构造函数
  * 初始化UI组件和工具页面
  */
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(ApiManager *apiManager, QWidget *parent)
     : QMainWindow(parent)
-    , m_currentTool(nullptr)
+    , m_toolStack(nullptr)
     , m_statusLabel(nullptr)
     , m_exitAction(nullptr)
     , m_aboutAction(nullptr)
@@ -29,41 +39,66 @@ MainWindow::MainWindow(QWidget *parent)
     , m_stringFormatterAction(nullptr)
     , m_userManagementAction(nullptr)
     , m_roleManagementAction(nullptr)
-    , m_stringFormatter(nullptr)
-    , m_userManager(nullptr)
-    , m_roleManager(nullptr)
-    , m_apiManager(new ApiManager(this))
+    , m_toolsMenu(nullptr)
+    , m_toolsSeparator(nullptr)
+    , m_idleReleaseTimer(nullptr)
+    , m_idleReleaseMinutes(0)
+    , m_apiManager(apiManager)
+    , m_changeFeed(nullptr)
 {
     qDebug() << "[DEBUG] MainWindow constructor called, instance:" << this;
-    setupUI();
-    createMenus();
-    createStatusBar();
-    initializeTools();
-    setupStyles();
-    
-    // 默认显示字符串格式化工具
-    showTool(m_stringFormatter);
     
     // 从设置中加载服务器URL和认证令牌
     QSettings settings;
     QString serverUrl = settings.value("server/url", "http://localhost:8001/api").toString();
-    m_apiManager->setBaseUrl(serverUrl);
-    
-    // 恢复认证令牌
-    QString savedToken = settings.value("auth/token").toString();
-    if (!savedToken.isEmpty()) {
-        m_apiManager->setAuthToken(savedToken);
+    if (m_apiManager) {
+        // 接管已验证过令牌的API管理器，已建立的连接与TLS会话继续复用
+        m_apiManager->setParent(this);
     } else {
-        qDebug() << "[DEBUG] MainWindow: No saved token found";
+        m_apiManager = new ApiManager(this);
+        m_apiManager->setBaseUrl(serverUrl);
+        
+        // 恢复认证令牌
+        QString savedToken = settings.value("auth/token").toString();
+        if (!savedToken.isEmpty()) {
+            m_apiManager->setAuthToken(savedToken);
+        } else {
+            qDebug() << "[DEBUG] MainWindow: No saved token found";
+        }
+        m_apiManager->warmUp();
+    }
+    
+    // 服务端没有令牌刷新接口时，用记住的密码静默重新登录
+    if (settings.value("login/remember", false).toBool()) {
+        m_apiManager->setCredentials(settings.value("login/username").toString(),
+                                     settings.value("login/password").toString());
     }
     
-    // 连接API管理器信号
-    connect(m_apiManager, &ApiManager::loginResult,
-            this, &MainWindow::onLoginResult);
-    connect(m_apiManager, &ApiManager::logoutResult,
-            this, &MainWindow::onLogoutResult);
+    setupUI();
+    createMenus();
+    createStatusBar();
+    initializeTools();
+    setupStyles();
+    
+    // 读取上次保存的实体快照，管理页面打开时先显示快照再后台同步
+    m_apiManager->entityStore()->openSnapshot(serverUrl, settings.value("auth/username").toString());
+    
+    // 连接API管理器会话信号
     connect(m_apiManager, &ApiManager::tokenExpired,
             this, &MainWindow::onTokenExpired);
+    connect(m_apiManager, &ApiManager::tokenRefreshed, this, [this](const QString &token) {
+        QSettings().setValue("auth/token", token);
+        updatePluginServerContext();
+    });
+    
+    // 订阅其他管理员的变更，页面随本地存储自动更新
+    m_changeFeed = new ChangeFeed(m_apiManager, this);
+    if (m_apiManager->isAuthenticated()) {
+        m_changeFeed->start();
+    }
+    
+    // 默认显示字符串格式化工具
+    showTool("string_formatter");
     
     // 显示欢迎信息
     QString username = settings.value("auth/username", "用户").toString();
@@ -91,8 +126,9 @@ void MainWindow::setupUI()
     setWindowTitle("DBA Tools - 工具集合");
     resize(800, 600);
     
-    // 中央widget将在showTool方法中设置
-    m_currentTool = nullptr;
+    // 工具页面常驻在页面栈中，切换工具不会销毁页面及其已加载的数据
+    m_toolStack = new QStackedWidget(this);
+    setCentralWidget(m_toolStack);
 }
 
 /**
@@ -134,6 +170,7 @@ void MainWindow::createMenus()
     
     // 工具菜单
     QMenu *toolsMenu = menuBar()->addMenu("工具(&T)");
+    m_toolsMenu = toolsMenu;
     qDebug() << "工具菜单创建完成:" << toolsMenu;
     qDebug() << "菜单栏:" << menuBar() << "是否可见:" << menuBar()->isVisible();
     
@@ -142,7 +179,8 @@ void MainWindow::createMenus()
     connect(m_stringFormatterAction, &QAction::triggered, this, &MainWindow::onStringFormatterClicked);
     toolsMenu->addAction(m_stringFormatterAction);
     
-    toolsMenu->addSeparator();
+    // 插件工具菜单项插入到此分隔符之前
+    m_toolsSeparator = toolsMenu->addSeparator();
     
     m_addToolAction = new QAction("添加工具(&A)", this);
     connect(m_addToolAction, &QAction::triggered, this, &MainWindow::onAddToolClicked);
@@ -193,19 +231,195 @@ void MainWindow::createStatusBar()
 
 /**
  * 初始化工具页面
+ * 这里只注册工厂函数，页面及其样式表在首次显示时才创建
  */
 void MainWindow::initializeTools()
 {
-    // 创建字符串格式化工具
-    m_stringFormatter = new StringFormatter(this);
+    // 字符串格式化工具
+    registerTool("string_formatter", "字符串格式化", [this]() -> QWidget* {
+        return new StringFormatter(this);
+    });
+    
+    // 用户管理工具
+    registerTool("user_manager", "用户管理", [this]() -> QWidget* {
+        return new UserManager(m_apiManager, this);
+    });
     
-    // 创建用户管理工具
-    m_userManager = new UserManager(m_apiManager, this);
+    // 角色管理工具
+    registerTool("role_manager", "角色管理", [this]() -> QWidget* {
+        return new RoleManager(m_apiManager, this);
+    });
     
-    // 创建角色管理工具
-    m_roleManager = new RoleManager(m_apiManager, this);
+    // 插件工具：只读取元数据生成菜单，插件库在首次打开时加载
+    loadToolPlugins();
     
-    // 可以在这里添加更多工具
+    // 可选：定期释放长时间未使用的页面以降低常驻内存，0表示不释放
+    QSettings settings;
+    m_idleReleaseMinutes = settings.value("tools/idle_release_minutes", 0).toInt();
+    if (m_idleReleaseMinutes > 0) {
+        m_idleReleaseTimer = new QTimer(this);
+        m_idleReleaseTimer->setInterval(60 * 1000);
+        connect(m_idleReleaseTimer, &QTimer::timeout, this, &MainWindow::releaseIdleTools);
+        m_idleReleaseTimer->start();
+    }
+}
+
+/**
+ * 注册工具页面工厂
+ */
+void MainWindow::registerTool(const QString &toolId, const QString &title, std::function<QWidget*()> factory)
+{
+    ToolEntry entry;
+    entry.title = title;
+    entry.factory = std::move(factory);
+    m_tools.insert(toolId, entry);
+}
+
+/**
+ * 插件目录
+ */
+QString MainWindow::toolPluginDir() const
+{
+    return QCoreApplication::applicationDirPath() + "/plugins/tools";
+}
+
+/**
+ * 扫描插件目录，按元数据注册插件工具
+ */
+void MainWindow::loadToolPlugins()
+{
+    QDir pluginDir(toolPluginDir());
+    if (!pluginDir.exists()) {
+        return;
+    }
+    
+    const QStringList entries = pluginDir.entryList(QDir::Files);
+    for (const QString &fileName : entries) {
+        QString filePath = pluginDir.absoluteFilePath(fileName);
+        if (QLibrary::isLibrary(filePath)) {
+            registerToolPlugin(filePath);
+        }
+    }
+}
+
+/**
+ * 按插件元数据注册一个插件工具
+ * QPluginLoader::metaData()只读取库中嵌入的元数据，不会加载库
+ */
+QString MainWindow::registerToolPlugin(const QString &filePath)
+{
+    QJsonObject toolInfo = toolPluginMetaData(filePath);
+    QString toolId = toolInfo.value("id").toString();
+    QString title = toolInfo.value("name").toString();
+    if (toolId.isEmpty() || m_tools.contains(toolId)) {
+        qDebug() << "[DEBUG] Invalid or duplicate tool plugin:" << filePath;
+        return QString();
+    }
+    
+    registerTool(toolId, title, [this, filePath]() -> QWidget* {
+        QPluginLoader loader(filePath);
+        QObject *instance = loader.instance();
+        ITool *tool = qobject_cast<ITool*>(instance);
+        if (!tool) {
+            qDebug() << "[DEBUG] Failed to load tool plugin:" << filePath << loader.errorString();
+            m_statusLabel->setText("加载插件失败: " + loader.errorString());
+            return nullptr;
+        }
+        tool->setServerContext(QUrl(m_apiManager->getBaseUrl()), m_apiManager->getAuthToken());
+        if (!m_pluginInstances.contains(instance)) {
+            m_pluginInstances.append(instance);
+        }
+        return tool->createWidget(this);
+    });
+    
+    QAction *action = new QAction(title, this);
+    action->setToolTip(toolInfo.value("description").toString());
+    connect(action, &QAction::triggered, this, [this, toolId]() {
+        showTool(toolId);
+    });
+    m_toolsMenu->insertAction(m_toolsSeparator, action);
+    
+    qDebug() << "[DEBUG] Registered tool plugin:" << toolId << filePath;
+    return toolId;
+}
+
+/**
+ * 向已加载的插件下发当前的服务器上下文
+ * 插件自行发出的请求使用下发的令牌，令牌刷新后需要同步，否则旧令牌过期后插件请求全部失败
+ */
+void MainWindow::updatePluginServerContext()
+{
+    QUrl baseUrl(m_apiManager->getBaseUrl());
+    QString token = m_apiManager->getAuthToken();
+    for (const QPointer<QObject> &instance : std::as_const(m_pluginInstances)) {
+        if (ITool *tool = qobject_cast<ITool*>(instance.data())) {
+            tool->setServerContext(baseUrl, token);
+        }
+    }
+}
+
+/**
+ * 读取插件库的工具元数据
+ * 只解析库文件中的元数据段，不加载插件库；IID不匹配或缺少id/name时返回空对象
+ */
+QJsonObject MainWindow::toolPluginMetaData(const QString &filePath)
+{
+    QPluginLoader probe(filePath);
+    QJsonObject metaData = probe.metaData();
+    if (metaData.value("IID").toString() != QLatin1String(ITool_iid)) {
+        qDebug() << "[DEBUG] Skipping non-tool plugin:" << filePath;
+        return QJsonObject();
+    }
+    
+    QJsonObject toolInfo = metaData.value("MetaData").toObject();
+    if (toolInfo.value("id").toString().isEmpty() || toolInfo.value("name").toString().isEmpty()) {
+        qDebug() << "[DEBUG] Invalid tool plugin metadata:" << filePath;
+        return QJsonObject();
+    }
+    return toolInfo;
+}
+
+/**
+ * 获取工具页面，未创建（或已被释放）时按需创建
+ */
+QWidget *MainWindow::toolWidget(const QString &toolId)
+{
+    auto it = m_tools.find(toolId);
+    if (it == m_tools.end()) {
+        qDebug() << "[DEBUG] Unknown tool id:" << toolId;
+        return nullptr;
+    }
+    
+    if (it->widget.isNull()) {
+        qDebug() << "[DEBUG] Creating tool page on demand:" << toolId;
+        it->widget = it->factory();
+        if (it->widget) {
+            m_toolStack->addWidget(it->widget);
+        }
+    }
+    it->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    return it->widget;
+}
+
+/**
+ * 释放长时间未使用的工具页面
+ * 当前显示的页面不会被释放，下次显示时会重新创建
+ */
+void MainWindow::releaseIdleTools()
+{
+    qint64 threshold = QDateTime::currentMSecsSinceEpoch() - qint64(m_idleReleaseMinutes) * 60 * 1000;
+    
+    for (auto it = m_tools.begin(); it != m_tools.end(); ++it) {
+        if (it.key() == m_currentToolId || it->widget.isNull()) {
+            continue;
+        }
+        if (it->lastUsed < threshold) {
+            qDebug() << "[DEBUG] Releasing idle tool page:" << it.key();
+            m_toolStack->removeWidget(it->widget);
+            it->widget->deleteLater();
+            it->widget.clear();
+        }
+    }
 }
 
 /**
@@ -378,12 +592,15 @@ void MainWindow::onLogoutClicked()
                                    QMessageBox::No);
     
     if (ret == QMessageBox::Yes) {
-        // 连接注销结果信号
-        connect(m_apiManager, &ApiManager::logoutResult,
-                this, &MainWindow::onLogoutResult, Qt::UniqueConnection);
+        m_changeFeed->stop();
+        
+        // 放弃所有进行中的请求，不再等待其结果
+        m_apiManager->cancelAll();
         
         // 调用API注销
-        m_apiManager->logout();
+        m_apiManager->logout()->then(this, [this](ApiReply *reply) {
+            onLogoutResult(reply);
+        });
         m_statusLabel->setText("正在注销...");
     }
 }
@@ -391,9 +608,10 @@ void MainWindow::onLogoutClicked()
 /**
  * 处理注销结果
  */
-void MainWindow::onLogoutResult(bool success, const QString &message)
+void MainWindow::onLogoutResult(ApiReply *reply)
 {
-    if (success) {
+    QString message = reply->isSuccess() ? reply->message() : reply->error();
+    if (reply->isSuccess()) {
         // 清除认证信息
         QSettings settings;
         settings.remove("auth/token");
@@ -411,23 +629,13 @@ void MainWindow::onLogoutResult(bool success, const QString &message)
     }
 }
 
-/**
- * 登录结果处理
- */
-void MainWindow::onLoginResult(bool success, const QString &message, const QString &token)
-{
-    if (success) {
-        // 登录成功，数据将在首次切换到对应标签页时自动加载
-        // 不在这里直接加载，避免与showEvent冲突
-    }
-}
-
 /**
  * 处理Token过期事件
  */
 void MainWindow::onTokenExpired()
 {
     qDebug() << "[DEBUG] Token expired, redirecting to login page";
+    m_changeFeed->stop();
     
     // 清除认证信息
     QSettings settings;
@@ -463,18 +671,84 @@ void MainWindow::onSettingsClicked()
     if (ok && !newUrl.isEmpty()) {
         settings.setValue("server/url", newUrl);
         m_apiManager->setBaseUrl(newUrl);
+        m_apiManager->warmUp();
+        m_apiManager->entityStore()->openSnapshot(newUrl, settings.value("auth/username").toString());
+        if (m_apiManager->isAuthenticated()) {
+            m_changeFeed->stop();
+            m_changeFeed->start();
+        }
         m_statusLabel->setText("服务器地址已更新");
     }
 }
 
 /**
  * 添加工具
+ * 选择插件库文件，复制到插件目录并注册到工具菜单
  */
 void MainWindow::onAddToolClicked()
 {
-    QMessageBox::information(this, "添加工具",
-                           "此功能将在后续版本中实现\n"
-                           "您可以通过扩展代码来添加新的工具页面");
+    QString filePath = QFileDialog::getOpenFileName(this, "添加工具插件", QString(),
+                                                    "工具插件 (*.dll *.so *.dylib)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    // 先校验所选文件的元数据，校验通过前不改动插件目录
+    QJsonObject toolInfo = toolPluginMetaData(filePath);
+    if (toolInfo.isEmpty()) {
+        QMessageBox::warning(this, "添加工具", "所选文件不是有效的DBA Tools工具插件");
+        return;
+    }
+    QString newToolId = toolInfo.value("id").toString();
+    if (m_tools.contains(newToolId)) {
+        QMessageBox::warning(this, "添加工具",
+                             QString("工具\"%1\"已存在").arg(m_tools.value(newToolId).title));
+        return;
+    }
+    
+    QDir pluginDir(toolPluginDir());
+    if (!pluginDir.exists() && !pluginDir.mkpath(".")) {
+        QMessageBox::warning(this, "添加工具", "无法创建插件目录: " + pluginDir.path());
+        return;
+    }
+    
+    QString targetPath = pluginDir.absoluteFilePath(QFileInfo(filePath).fileName());
+    if (QFileInfo(targetPath) != QFileInfo(filePath)) {
+        if (QFileInfo::exists(targetPath)) {
+            // 同名文件属于已注册的工具时，其插件库可能已加载，不能覆盖
+            QString existingId = toolPluginMetaData(targetPath).value("id").toString();
+            if (m_tools.contains(existingId)) {
+                QMessageBox::warning(this, "添加工具",
+                                     QString("插件目录中的同名文件属于已添加的工具\"%1\"，无法覆盖")
+                                     .arg(m_tools.value(existingId).title));
+                return;
+            }
+            
+            QMessageBox::StandardButton answer = QMessageBox::question(
+                this, "添加工具", QString("插件目录中已存在文件 %1，是否覆盖？").arg(QFileInfo(targetPath).fileName()),
+                QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+            if (answer != QMessageBox::Yes) {
+                return;
+            }
+            if (!QFile::remove(targetPath)) {
+                QMessageBox::warning(this, "添加工具", "无法覆盖插件文件: " + targetPath);
+                return;
+            }
+        }
+        if (!QFile::copy(filePath, targetPath)) {
+            QMessageBox::warning(this, "添加工具", "复制插件文件失败: " + targetPath);
+            return;
+        }
+    }
+    
+    QString toolId = registerToolPlugin(targetPath);
+    if (toolId.isEmpty()) {
+        QMessageBox::warning(this, "添加工具", "注册工具插件失败: " + targetPath);
+        return;
+    }
+    
+    m_statusLabel->setText("已添加工具: " + m_tools.value(toolId).title);
+    showTool(toolId);
 }
 
 /**
@@ -483,7 +757,7 @@ void MainWindow::onAddToolClicked()
 void MainWindow::onUserManagementClicked()
 {
     qDebug() << "用户管理菜单被点击";
-    showTool(m_userManager);
+    showTool("user_manager");
 }
 
 /**
@@ -492,7 +766,7 @@ void MainWindow::onUserManagementClicked()
 void MainWindow::onRoleManagementClicked()
 {
     qDebug() << "角色管理菜单被点击";
-    showTool(m_roleManager);
+    showTool("role_manager");
 }
 
 /**
@@ -501,31 +775,32 @@ void MainWindow::onRoleManagementClicked()
 void MainWindow::onStringFormatterClicked()
 {
     qDebug() << "字符串格式化菜单被点击";
-    showTool(m_stringFormatter);
+    showTool("string_formatter");
 }
 
 /**
  * 显示指定工具页面
+ * 切换前后分别调用页面的停用/激活回调
  */
-void MainWindow::showTool(QWidget* tool)
+void MainWindow::showTool(const QString &toolId)
 {
-    if (m_currentTool == tool) {
+    QWidget *tool = toolWidget(toolId);
+    if (!tool || m_currentTool == tool) {
         return; // 已经是当前工具，无需切换
     }
     
-    // 隐藏当前工具
-    if (m_currentTool) {
-        m_currentTool->hide();
+    // 停用当前工具
+    if (IToolPage *page = qobject_cast<IToolPage*>(m_currentTool.data())) {
+        page->deactivateTool();
     }
     
     // 设置新的当前工具
     m_currentTool = tool;
-    setCentralWidget(m_currentTool);
+    m_currentToolId = toolId;
+    m_toolStack->setCurrentWidget(tool);
     
-    // 触发显示事件
-    if (m_currentTool) {
-        QShowEvent showEvent;
-        QApplication::sendEvent(m_currentTool, &showEvent);
-        m_currentTool->show();
+    // 激活新工具
+    if (IToolPage *page = qobject_cast<IToolPage*>(tool)) {
+        page->activateTool();
     }
 }
\ No newline at end of file
@@ -8,23 +8,30 @@
 #include <QAction>
 #include <QLabel>
 #include <QSettings>
+#include <QStackedWidget>
+#include <QPointer>
+#include <QTimer>
+#include <QMap>
+#include <QJsonObject>
+#include <functional>
 #include "apimanager.h"
 
 QT_BEGIN_NAMESPACE
 class QTabWidget;
 class QLabel;
+class QStackedWidget;
 QT_END_NAMESPACE
 
-class StringFormatter;
-class UserManager;
-class RoleManager;
+class ChangeFeed;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // apiManager为已配置好地址与令牌的API管理器（启动时验证过保存的令牌），主窗口接管后继续使用；
+    // 为空时按设置新建
+    explicit MainWindow(ApiManager *apiManager = nullptr, QWidget *parent = nullptr);
     ~MainWindow();
 
 private slots:
@@ -32,8 +39,7 @@ private slots:
     void onAboutClicked();
     void onExitClicked();
     void onLogoutClicked();
-    void onLogoutResult(bool success, const QString &message);
-    void onLoginResult(bool success, const QString &message, const QString &token);
+    void onLogoutResult(ApiReply *reply);
     void onTokenExpired();
     void onSettingsClicked();
     
@@ -46,11 +52,15 @@ private slots:
     
     // 工具切换
     void onStringFormatterClicked();
-    void showTool(QWidget* tool);
+    void showTool(const QString &toolId);
+    
+    // 释放长时间未使用的工具页面
+    void releaseIdleTools();
 
 private:
     // UI组件
-    QWidget *m_currentTool;
+    QStackedWidget *m_toolStack;
+    QPointer<QWidget> m_currentTool;
     QLabel *m_statusLabel;
     
     // 菜单和动作
@@ -62,15 +72,30 @@ private:
     QAction *m_stringFormatterAction;
     QAction *m_userManagementAction;
     QAction *m_roleManagementAction;
+    QMenu *m_toolsMenu;
+    QAction *m_toolsSeparator;
+    
+    // 工具页面注册表：页面在首次显示时才通过工厂函数创建
+    struct ToolEntry {
+        QString title;
+        std::function<QWidget*()> factory;
+        QPointer<QWidget> widget;
+        qint64 lastUsed = 0;
+    };
+    QMap<QString, ToolEntry> m_tools;
     
-    // 工具页面
-    StringFormatter *m_stringFormatter;
-    UserManager *m_userManager;
-    RoleManager *m_roleManager;
+    // 已加载的插件实例（插件库加载后不卸载），令牌刷新时重新下发服务器上下文
+    QList<QPointer<QObject>> m_pluginInstances;
+    QString m_currentToolId;
+    QTimer *m_idleReleaseTimer;
+    int m_idleReleaseMinutes;
     
     // API管理器
     ApiManager *m_apiManager;
     
+    // 用户/角色变更推送通道
+    ChangeFeed *m_changeFeed;
+    
     // 初始化UI
     void setupUI();
     
@@ -83,6 +108,27 @@ private:
     // 初始化工具页面
     void initializeTools();
     
+    // 注册工具页面工厂
+    void registerTool(const QString &toolId, const QString &title, std::function<QWidget*()> factory);
+    
+    // 获取工具页面，未创建时按需创建
+    QWidget *toolWidget(const QString &toolId);
+    
+    // 插件目录
+    QString toolPluginDir() const;
+    
+    // 扫描插件目录，按元数据注册插件工具（不加载插件库）
+    void loadToolPlugins();
+    
+    // 向已加载的插件下发当前的服务器地址与令牌
+    void updatePluginServerContext();
+    
+    // 读取插件库的工具元数据（不加载插件库），不是有效的工具插件时返回空对象
+    static QJsonObject toolPluginMetaData(const QString &filePath);
+    
+    // 按插件元数据注册一个插件工具并添加菜单项，返回工具ID，失败返回空字符串
+    QString registerToolPlugin(const QString &filePath);
+    
     // 设置样式
     void setupStyles();
 };
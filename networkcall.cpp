@@ -0,0 +1,47 @@
+#include "networkcall.h"
+#include "networkthread.h"
+
+/**
+ * 请求句柄构造函数
+ */
+NetworkCall::NetworkCall(NetworkThread *thread, int id, const QNetworkRequest &request)
+    : QObject(thread)
+    , m_thread(thread)
+    , m_id(id)
+    , m_request(request)
+    , m_finished(false)
+{
+}
+
+/**
+ * 读取响应头，名称不区分大小写
+ */
+QByteArray NetworkResponse::rawHeader(const QByteArray &name) const
+{
+    for (const QNetworkReply::RawHeaderPair &header : headers) {
+        if (header.first.compare(name, Qt::CaseInsensitive) == 0) {
+            return header.second;
+        }
+    }
+    return QByteArray();
+}
+
+/**
+ * 中止请求
+ */
+void NetworkCall::abort()
+{
+    if (!m_finished) {
+        m_thread->abort(m_id);
+    }
+}
+
+/**
+ * 保存网络线程送回的响应并通知调用方
+ */
+void NetworkCall::complete(const NetworkResponse &response)
+{
+    m_response = response;
+    m_finished = true;
+    emit finished();
+}
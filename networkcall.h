@@ -0,0 +1,104 @@
+#ifndef NETWORKCALL_H
+#define NETWORKCALL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QVariant>
+
+class NetworkThread;
+
+// 网络线程中完成的请求结果（状态、响应头、响应体的快照）
+struct NetworkResponse {
+    // 超时类型：整体超时、建立连接超时、连续无数据的读取超时
+    enum TimeoutKind { NoTimeout, TotalTimeout, ConnectTimeout, ReadTimeout };
+    
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QString errorString;
+    TimeoutKind timeoutKind = NoTimeout;
+    QString timeoutError;       // 因超时中止时为超时原因，否则为空
+    QHash<int, QVariant> attributes;
+    QList<QNetworkReply::RawHeaderPair> headers;
+    QByteArray body;
+    QByteArray sessionTicket;
+    int sessionTicketLifetimeHint = -1;
+    QVariant decoded;           // 发出请求时给出解码函数时，在网络线程中解码的结果
+    
+    // 读取响应头，名称不区分大小写
+    QByteArray rawHeader(const QByteArray &name) const;
+    
+    // 错误描述，因超时中止时为超时原因
+    QString displayError() const { return timeoutError.isEmpty() ? errorString : timeoutError; }
+};
+
+/**
+ * 网络线程中单个请求在调用线程中的句柄
+ * 接口与ApiManager用到的QNetworkReply部分一致；请求完成后响应整体送回调用线程，
+ * 之后读取状态、响应头与响应体都不再跨线程。句柄由调用方在处理完finished后释放
+ */
+class NetworkCall : public QObject
+{
+    Q_OBJECT
+
+public:
+    NetworkCall(NetworkThread *thread, int id, const QNetworkRequest &request);
+    
+    /**
+     * 请求信息
+     */
+    const QNetworkRequest &request() const { return m_request; }
+    QUrl url() const { return m_request.url(); }
+    
+    /**
+     * 请求结果（finished之后有效）
+     */
+    bool isFinished() const { return m_finished; }
+    QNetworkReply::NetworkError error() const { return m_response.error; }
+    QVariant attribute(QNetworkRequest::Attribute code) const { return m_response.attributes.value(code); }
+    QByteArray rawHeader(const QByteArray &name) const { return m_response.rawHeader(name); }
+    const QByteArray &body() const { return m_response.body; }
+    const QVariant &decoded() const { return m_response.decoded; }
+    
+    /**
+     * 错误描述，因超时中止时为超时原因
+     */
+    QString errorString() const { return m_response.displayError(); }
+    QString timeoutError() const { return m_response.timeoutError; }
+    
+    /**
+     * 超时类型，不是因超时中止时为NoTimeout
+     */
+    NetworkResponse::TimeoutKind timeoutKind() const { return m_response.timeoutKind; }
+    
+    /**
+     * 服务端下发的TLS会话票据及其有效期（秒，-1表示未给出）
+     */
+    QByteArray sessionTicket() const { return m_response.sessionTicket; }
+    int sessionTicketLifetimeHint() const { return m_response.sessionTicketLifetimeHint; }
+    
+    /**
+     * 中止请求，完成后同样发出finished（错误为OperationCanceledError）
+     */
+    void abort();
+
+signals:
+    // 请求完成（成功、失败或中止）
+    void finished();
+
+private:
+    friend class NetworkThread;
+    
+    // 由NetworkThread在调用线程中调用
+    void complete(const NetworkResponse &response);
+    
+    NetworkThread *m_thread;
+    int m_id;
+    QNetworkRequest m_request;
+    NetworkResponse m_response;
+    bool m_finished;
+};
+
+#endif // NETWORKCALL_H
@@ -0,0 +1,331 @@
+#include "networkthread.h"
+#include <QDebug>
+#include <QNetworkAccessManager>
+#include <QNetworkDiskCache>
+#include <QThread>
+#include <QTimer>
+
+/**
+ * 网络线程中的工作对象
+ * 只在网络线程中访问，调用线程通过post()投递任务
+ */
+class NetworkThread::Worker : public QObject
+{
+public:
+    explicit Worker(NetworkThread *owner);
+    
+    void init();
+    void start(int id, const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+               const NetworkThread::Decoder &decode);
+    void abort(int id);
+    void armTimeouts(QNetworkReply *reply);
+    
+    // 结果投递的目标，只作为投递对象使用，不在网络线程中访问其成员
+    NetworkThread *m_owner;
+    QNetworkAccessManager *m_networkManager;
+    QNetworkDiskCache *m_diskCache;
+    QHash<int, QNetworkReply *> m_replies;
+    int m_timeoutMs;
+    int m_connectTimeoutMs;
+    int m_readTimeoutMs;
+};
+
+NetworkThread::Worker::Worker(NetworkThread *owner)
+    : m_owner(owner)
+    , m_networkManager(nullptr)
+    , m_diskCache(nullptr)
+    , m_timeoutMs(0)
+    , m_connectTimeoutMs(0)
+    , m_readTimeoutMs(0)
+{
+}
+
+/**
+ * 在网络线程中创建QNetworkAccessManager，使其内部对象都归属网络线程
+ */
+void NetworkThread::Worker::init()
+{
+    m_networkManager = new QNetworkAccessManager(this);
+}
+
+/**
+ * 超时中止请求，记录原因供错误处理区分调用方取消与超时
+ */
+static void abortWithTimeout(QNetworkReply *reply, NetworkResponse::TimeoutKind kind, const QString &reason)
+{
+    if (reply->isFinished()) {
+        return;
+    }
+    qDebug() << "[DEBUG] Request timed out:" << reason << reply->url().toString();
+    reply->setProperty("timeoutKind", int(kind));
+    reply->setProperty("timeoutError", reason);
+    reply->abort();
+}
+
+/**
+ * 按HTTP方法发出请求，完成后把响应快照（及解码结果）送回调用线程
+ */
+void NetworkThread::Worker::start(int id, const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+                                  const NetworkThread::Decoder &decode)
+{
+    QNetworkReply *reply;
+    if (method == "GET") {
+        reply = m_networkManager->get(request);
+    } else if (method == "POST") {
+        reply = m_networkManager->post(request, body);
+    } else if (method == "PUT") {
+        reply = m_networkManager->put(request, body);
+    } else if (method == "DELETE") {
+        reply = m_networkManager->deleteResource(request);
+    } else {
+        reply = m_networkManager->sendCustomRequest(request, method, body);
+    }
+    
+    m_replies.insert(id, reply);
+    armTimeouts(reply);
+    
+    connect(reply, &QNetworkReply::finished, this, [this, id, reply, decode]() {
+        m_replies.remove(id);
+        reply->deleteLater();
+        
+        NetworkResponse response;
+        response.error = reply->error();
+        response.errorString = reply->errorString();
+        response.timeoutKind = NetworkResponse::TimeoutKind(reply->property("timeoutKind").toInt());
+        response.timeoutError = reply->property("timeoutError").toString();
+        for (QNetworkRequest::Attribute code : {QNetworkRequest::HttpStatusCodeAttribute,
+                                                QNetworkRequest::HttpReasonPhraseAttribute,
+                                                QNetworkRequest::Http2WasUsedAttribute,
+                                                QNetworkRequest::SourceIsFromCacheAttribute}) {
+            response.attributes.insert(code, reply->attribute(code));
+        }
+        response.headers = reply->rawHeaderPairs();
+        response.body = reply->readAll();
+#ifndef QT_NO_SSL
+        // TLS 1.3的会话票据在握手完成后才下发，因此在请求结束时读取
+        if (reply->url().scheme() == "https") {
+            QSslConfiguration ssl = reply->sslConfiguration();
+            response.sessionTicket = ssl.sessionTicket();
+            response.sessionTicketLifetimeHint = ssl.sessionTicketLifeTimeHint();
+        }
+#endif
+        if (decode) {
+            response.decoded = decode(response);
+        }
+        
+        NetworkThread *owner = m_owner;
+        QMetaObject::invokeMethod(owner, [owner, id, response]() {
+            owner->complete(id, response);
+        }, Qt::QueuedConnection);
+    });
+}
+
+/**
+ * 中止请求，已完成的请求忽略
+ */
+void NetworkThread::Worker::abort(int id)
+{
+    QNetworkReply *reply = m_replies.value(id);
+    if (reply) {
+        reply->abort();
+    }
+}
+
+/**
+ * 为发出的请求设置超时
+ * 定时器以请求为父对象，请求释放时一并释放
+ */
+void NetworkThread::Worker::armTimeouts(QNetworkReply *reply)
+{
+    // 整体超时：从发出到完成的总时间
+    if (m_timeoutMs > 0) {
+        QTimer::singleShot(m_timeoutMs, reply, [reply]() {
+            abortWithTimeout(reply, NetworkResponse::TotalTimeout, "请求超时");
+        });
+    }
+    
+    // 连接超时：请求发出前（DNS、TCP、TLS握手）的时间；
+    // 早于Qt 6.3的版本没有requestSent信号，无法区分建立连接与等待服务端处理，
+    // 不设连接超时（否则处理较慢的GET会被当作连接失败而切换节点），只由整体超时与读取超时兜底
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    if (m_connectTimeoutMs > 0) {
+        QTimer *connectTimer = new QTimer(reply);
+        connectTimer->setSingleShot(true);
+        connect(connectTimer, &QTimer::timeout, reply, [reply]() {
+            abortWithTimeout(reply, NetworkResponse::ConnectTimeout, "连接服务器超时");
+        });
+        connect(reply, &QNetworkReply::requestSent, connectTimer, &QTimer::stop);
+        connect(reply, &QNetworkReply::metaDataChanged, connectTimer, &QTimer::stop);
+        connect(reply, &QNetworkReply::uploadProgress, connectTimer, [connectTimer](qint64 sent, qint64) {
+            if (sent > 0) {
+                connectTimer->stop();
+            }
+        });
+        connectTimer->start(m_connectTimeoutMs);
+    }
+#endif
+    
+    // 读取超时：连续一段时间没有收发任何数据
+    if (m_readTimeoutMs > 0) {
+        QTimer *readTimer = new QTimer(reply);
+        readTimer->setSingleShot(true);
+        connect(readTimer, &QTimer::timeout, reply, [reply]() {
+            abortWithTimeout(reply, NetworkResponse::ReadTimeout, "读取响应超时");
+        });
+        connect(reply, &QNetworkReply::downloadProgress, readTimer, [readTimer]() {
+            readTimer->start();
+        });
+        connect(reply, &QNetworkReply::uploadProgress, readTimer, [readTimer]() {
+            readTimer->start();
+        });
+        readTimer->start(m_readTimeoutMs);
+    }
+}
+
+/**
+ * 网络线程构造函数
+ * 工作对象移到新线程后再启动，QNetworkAccessManager在线程开始运行时于网络线程中创建；
+ * started在事件循环开始前发出，先于投递给工作对象的任务执行
+ */
+NetworkThread::NetworkThread(QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread(this))
+    , m_worker(new Worker(this))
+    , m_nextId(1)
+{
+    m_thread->setObjectName("network");
+    m_worker->moveToThread(m_thread);
+    Worker *worker = m_worker;
+    connect(m_thread, &QThread::started, m_worker, [worker]() {
+        worker->init();
+    });
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    m_thread->start();
+}
+
+/**
+ * 网络线程析构函数
+ * 退出事件循环并等待线程结束，工作对象与未完成的请求随之释放
+ */
+NetworkThread::~NetworkThread()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+/**
+ * 在网络线程中执行任务
+ */
+void NetworkThread::post(std::function<void(Worker *)> task)
+{
+    Worker *worker = m_worker;
+    QMetaObject::invokeMethod(worker, [worker, task]() {
+        task(worker);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * 设置超时
+ */
+void NetworkThread::setTimeouts(int totalMs, int connectMs, int readMs)
+{
+    post([totalMs, connectMs, readMs](Worker *worker) {
+        worker->m_timeoutMs = totalMs;
+        worker->m_connectTimeoutMs = connectMs;
+        worker->m_readTimeoutMs = readMs;
+    });
+}
+
+/**
+ * 启用磁盘缓存（缓存对象在网络线程中创建，归QNetworkAccessManager所有）
+ */
+void NetworkThread::setDiskCache(const QString &directory, qint64 maxSize)
+{
+    post([directory, maxSize](Worker *worker) {
+        QNetworkDiskCache *cache = new QNetworkDiskCache;
+        cache->setCacheDirectory(directory);
+        cache->setMaximumCacheSize(maxSize);
+        worker->m_networkManager->setCache(cache);
+        worker->m_diskCache = cache;
+    });
+}
+
+/**
+ * 清空磁盘缓存
+ */
+void NetworkThread::clearDiskCache()
+{
+    post([](Worker *worker) {
+        if (worker->m_diskCache) {
+            worker->m_diskCache->clear();
+        }
+    });
+}
+
+/**
+ * 从磁盘缓存中移除一个地址
+ */
+void NetworkThread::removeFromDiskCache(const QUrl &url)
+{
+    post([url](Worker *worker) {
+        if (worker->m_diskCache) {
+            worker->m_diskCache->remove(url);
+        }
+    });
+}
+
+/**
+ * 发出请求
+ */
+NetworkCall *NetworkThread::send(const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+                                 const Decoder &decode)
+{
+    int id = m_nextId++;
+    NetworkCall *call = new NetworkCall(this, id, request);
+    m_calls.insert(id, call);
+    
+    post([id, method, request, body, decode](Worker *worker) {
+        worker->start(id, method, request, body, decode);
+    });
+    return call;
+}
+
+/**
+ * 预先建立连接
+ */
+void NetworkThread::connectToHost(const QString &host, quint16 port)
+{
+    post([host, port](Worker *worker) {
+        worker->m_networkManager->connectToHost(host, port);
+    });
+}
+
+#ifndef QT_NO_SSL
+void NetworkThread::connectToHostEncrypted(const QString &host, quint16 port, const QSslConfiguration &ssl)
+{
+    post([host, port, ssl](Worker *worker) {
+        worker->m_networkManager->connectToHostEncrypted(host, port, ssl);
+    });
+}
+#endif
+
+/**
+ * 中止请求
+ */
+void NetworkThread::abort(int id)
+{
+    post([id](Worker *worker) {
+        worker->abort(id);
+    });
+}
+
+/**
+ * 网络线程送回响应，转交给对应的句柄（句柄已释放时丢弃）
+ */
+void NetworkThread::complete(int id, const NetworkResponse &response)
+{
+    QPointer<NetworkCall> call = m_calls.take(id);
+    if (call) {
+        call->complete(response);
+    }
+}
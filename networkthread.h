@@ -0,0 +1,85 @@
+#ifndef NETWORKTHREAD_H
+#define NETWORKTHREAD_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QUrl>
+#include <functional>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+#include "networkcall.h"
+
+class QThread;
+
+/**
+ * 专用网络线程
+ * QNetworkAccessManager（以及可选的磁盘缓存）运行在独立线程的事件循环中，
+ * 套接字读写、TLS、响应解压与超时都不受界面线程绘制的影响，大响应的接收也不会阻塞界面。
+ * 调用线程通过send()发出请求并得到NetworkCall句柄，请求完成后响应（及解码结果）整体送回调用线程
+ */
+class NetworkThread : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetworkThread(QObject *parent = nullptr);
+    ~NetworkThread();
+    
+    // 在网络线程中解码响应的函数，结果通过NetworkCall::decoded()读取
+    using Decoder = std::function<QVariant(const NetworkResponse &)>;
+    
+    /**
+     * 设置超时（毫秒，0表示不限制）：整体超时、连接超时、连续无数据的读取超时
+     */
+    void setTimeouts(int totalMs, int connectMs, int readMs);
+    
+    /**
+     * 启用磁盘缓存
+     */
+    void setDiskCache(const QString &directory, qint64 maxSize);
+    
+    /**
+     * 清空磁盘缓存或移除其中一个地址，未启用磁盘缓存时不做任何事
+     */
+    void clearDiskCache();
+    void removeFromDiskCache(const QUrl &url);
+    
+    /**
+     * 按HTTP方法发出请求，句柄的父对象为NetworkThread；
+     * 给出解码函数时响应在网络线程中解码，不占用调用线程
+     */
+    NetworkCall *send(const QByteArray &method, const QNetworkRequest &request, const QByteArray &body,
+                      const Decoder &decode = Decoder());
+    
+    /**
+     * 预先建立连接
+     */
+    void connectToHost(const QString &host, quint16 port);
+#ifndef QT_NO_SSL
+    void connectToHostEncrypted(const QString &host, quint16 port, const QSslConfiguration &ssl);
+#endif
+
+private:
+    class Worker;
+    friend class NetworkCall;
+    
+    // 中止请求（由NetworkCall调用）
+    void abort(int id);
+    
+    // 网络线程送回响应
+    void complete(int id, const NetworkResponse &response);
+    
+    // 在网络线程中执行任务
+    void post(std::function<void(Worker *)> task);
+    
+    QThread *m_thread;
+    Worker *m_worker;
+    QHash<int, QPointer<NetworkCall>> m_calls;
+    int m_nextId;
+};
+
+#endif // NETWORKTHREAD_H
@@ -0,0 +1,120 @@
+#include "responsecache.h"
+#include <QDateTime>
+#include <QDebug>
+
+/**
+ * 响应缓存构造函数
+ * 以响应体字节数作为开销，超出上限时淘汰最久未使用的条目
+ */
+ResponseCache::ResponseCache(int maxBytes)
+    : m_entries(maxBytes)
+{
+}
+
+/**
+ * 设置端点路径前缀的有效期
+ */
+void ResponseCache::setTtl(const QString &pathPrefix, int seconds)
+{
+    for (QPair<QString, int> &ttl : m_ttls) {
+        if (ttl.first == pathPrefix) {
+            ttl.second = seconds;
+            return;
+        }
+    }
+    m_ttls.append(qMakePair(pathPrefix, seconds));
+}
+
+/**
+ * 获取端点路径的有效期，取最长匹配前缀
+ */
+int ResponseCache::ttlFor(const QString &path) const
+{
+    int matchedLength = -1;
+    int seconds = 0;
+    for (const QPair<QString, int> &ttl : m_ttls) {
+        if (path.startsWith(ttl.first) && ttl.first.size() > matchedLength) {
+            matchedLength = ttl.first.size();
+            seconds = ttl.second;
+        }
+    }
+    return seconds;
+}
+
+/**
+ * 查找缓存条目
+ */
+bool ResponseCache::lookup(const QString &key, Entry *entry) const
+{
+    const Entry *cached = m_entries.object(key);
+    if (!cached) {
+        return false;
+    }
+    *entry = *cached;
+    return true;
+}
+
+/**
+ * 判断条目是否仍在有效期内
+ */
+bool ResponseCache::isFresh(const Entry &entry)
+{
+    return QDateTime::currentMSecsSinceEpoch() < entry.expiresAt;
+}
+
+/**
+ * 保存响应
+ */
+void ResponseCache::store(const QString &key, const Entry &entry)
+{
+    int ttl = ttlFor(entry.path);
+    if (ttl <= 0) {
+        return;
+    }
+    
+    Entry *cached = new Entry(entry);
+    cached->expiresAt = QDateTime::currentMSecsSinceEpoch() + qint64(ttl) * 1000;
+    
+    // 超过缓存上限的单个响应不缓存，QCache会直接释放该条目
+    m_entries.insert(key, cached, qMax(1, int(cached->body.size())));
+}
+
+/**
+ * 收到304时延长条目有效期
+ */
+void ResponseCache::refresh(const QString &key)
+{
+    Entry *cached = m_entries.object(key);
+    if (cached) {
+        cached->expiresAt = QDateTime::currentMSecsSinceEpoch() + qint64(ttlFor(cached->path)) * 1000;
+    }
+}
+
+/**
+ * 移除路径以指定前缀开头的条目
+ */
+QList<QUrl> ResponseCache::invalidate(const QString &pathPrefix)
+{
+    QList<QUrl> urls;
+    const QList<QString> keys = m_entries.keys();
+    for (const QString &key : keys) {
+        const Entry *cached = m_entries.object(key);
+        if (cached && cached->path.startsWith(pathPrefix)) {
+            urls.append(cached->url);
+            m_entries.remove(key);
+        }
+    }
+    
+    if (!urls.isEmpty()) {
+        qDebug() << "[DEBUG] ResponseCache: invalidated" << urls.size() << "entries under" << pathPrefix;
+    }
+    return urls;
+}
+
+/**
+ * 清空缓存
+ */
+void ResponseCache::clear()
+{
+    m_entries.clear();
+}
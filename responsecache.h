@@ -0,0 +1,78 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QUrl>
+
+/**
+ * API响应缓存（内存层）
+ * 按端点路径前缀配置有效期，有效期内直接返回缓存内容；
+ * 过期后保留ETag/Last-Modified用于条件请求，服务端返回304时复用缓存内容。
+ * 缓存键包含完整URL与认证令牌，不同用户之间互不共享
+ */
+class ResponseCache
+{
+public:
+    // 缓存条目
+    struct Entry {
+        QUrl url;
+        QString path;
+        QByteArray body;
+        QByteArray contentType;
+        QByteArray etag;
+        QByteArray lastModified;
+        qint64 expiresAt = 0;
+    };
+    
+    explicit ResponseCache(int maxBytes = 8 * 1024 * 1024);
+    
+    /**
+     * 设置端点路径前缀的有效期（秒），0表示该前缀不缓存
+     */
+    void setTtl(const QString &pathPrefix, int seconds);
+    
+    /**
+     * 获取端点路径的有效期（秒），取最长匹配前缀，未配置返回0
+     */
+    int ttlFor(const QString &path) const;
+    
+    /**
+     * 查找缓存条目，不存在返回false
+     */
+    bool lookup(const QString &key, Entry *entry) const;
+    
+    /**
+     * 判断条目是否仍在有效期内
+     */
+    static bool isFresh(const Entry &entry);
+    
+    /**
+     * 保存响应，有效期按路径前缀计算
+     */
+    void store(const QString &key, const Entry &entry);
+    
+    /**
+     * 收到304时延长条目有效期
+     */
+    void refresh(const QString &key);
+    
+    /**
+     * 移除路径以指定前缀开头的条目，返回被移除条目的URL
+     */
+    QList<QUrl> invalidate(const QString &pathPrefix);
+    
+    /**
+     * 清空缓存
+     */
+    void clear();
+
+private:
+    QCache<QString, Entry> m_entries;
+    QList<QPair<QString, int>> m_ttls;
+};
+
+#endif // RESPONSECACHE_H
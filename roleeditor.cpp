@@ -26,11 +26,6 @@ RoleEditor::RoleEditor(ApiManager *apiManager, QWidget *parent)
     setupStyles();
     loadPermissions();
     
-    // 连接API管理器信号
-    connect(m_apiManager, &ApiManager::permissionListResult, this, &RoleEditor::onPermissionListResult);
-    connect(m_apiManager, &ApiManager::createRoleResult, this, &RoleEditor::onCreateRoleResult);
-    connect(m_apiManager, &ApiManager::networkError, this, &RoleEditor::onNetworkError);
-    
     // 连接按钮信号
     connect(m_okButton, &QPushButton::clicked, this, &RoleEditor::onOkClicked);
     connect(m_cancelButton, &QPushButton::clicked, this, &RoleEditor::onCancelClicked);
@@ -57,16 +52,12 @@ RoleEditor::RoleEditor(ApiManager *apiManager, const RoleInfo &role, QWidget *pa
     setupUI();
     setupStyles();
     loadPermissions();
+    loadRoleDetail();
     
     // 填充现有角色信息
     m_nameEdit->setText(role.name);
     m_descriptionEdit->setPlainText(role.description);
     
-    // 连接API管理器信号
-    connect(m_apiManager, &ApiManager::permissionListResult, this, &RoleEditor::onPermissionListResult);
-    connect(m_apiManager, &ApiManager::updateRoleResult, this, &RoleEditor::onUpdateRoleResult);
-    connect(m_apiManager, &ApiManager::networkError, this, &RoleEditor::onNetworkError);
-    
     // 连接按钮信号
     connect(m_okButton, &QPushButton::clicked, this, &RoleEditor::onOkClicked);
     connect(m_cancelButton, &QPushButton::clicked, this, &RoleEditor::onCancelClicked);
@@ -214,7 +205,19 @@ void RoleEditor::setupStyles()
 void RoleEditor::loadPermissions()
 {
     showStatus("正在加载权限列表...");
-    m_apiManager->getPermissionList();
+    m_apiManager->getPermissionList()->then(this, [this](ApiReply *reply) {
+        onPermissionListResult(reply);
+    });
+}
+
+/**
+ * 加载角色详情
+ */
+void RoleEditor::loadRoleDetail()
+{
+    m_apiManager->getRoleInfo(m_originalRole.id)->then(this, [this](ApiReply *reply) {
+        onRoleDetailResult(reply);
+    });
 }
 
 /**
@@ -345,10 +348,16 @@ void RoleEditor::onOkClicked()
     
     if (m_isEditMode) {
         showStatus("正在更新角色...");
-        m_apiManager->updateRole(role.id, role.displayName, role.description, role.isActive);
+        m_apiManager->updateRole(role.id, role.displayName, role.description, role.isActive)
+            ->then(this, [this](ApiReply *reply) {
+                onUpdateRoleResult(reply);
+            });
     } else {
         showStatus("正在创建角色...");
-        m_apiManager->createRole(role.name, role.displayName, role.description);
+        m_apiManager->createRole(role.name, role.displayName, role.description)
+            ->then(this, [this](ApiReply *reply) {
+                onCreateRoleResult(reply);
+            });
     }
     
     m_okButton->setEnabled(false);
@@ -365,57 +374,75 @@ void RoleEditor::onCancelClicked()
 /**
  * 权限列表结果处理
  */
-void RoleEditor::onPermissionListResult(bool success, const QList<PermissionInfo> &permissions, const QString &error)
+void RoleEditor::onPermissionListResult(ApiReply *reply)
 {
-    if (success) {
-        m_availablePermissions = permissions;
+    if (reply->isSuccess()) {
+        m_availablePermissions = reply->value<QList<PermissionInfo>>();
         updatePermissionDisplay();
         showStatus("权限列表加载完成");
     } else {
-        showStatus(QString("加载权限列表失败: %1").arg(error), true);
+        showStatus(QString("加载权限列表失败: %1").arg(reply->error()), true);
     }
 }
 
+/**
+ * 角色详情结果处理
+ */
+void RoleEditor::onRoleDetailResult(ApiReply *reply)
+{
+    if (!reply->isSuccess()) {
+        showStatus(QString("加载角色权限失败: %1").arg(reply->error()), true);
+        return;
+    }
+    
+    // 只取权限明细，保留用户已经修改的名称与描述
+    RoleInfo detail = reply->value<RoleInfo>();
+    m_originalRole.permissions = detail.permissions;
+    m_originalRole.permissionCount = detail.permissionCount;
+    
+    QList<int> rolePermissions;
+    for (const PermissionInfo &permission : m_originalRole.permissions) {
+        rolePermissions.append(permission.id);
+    }
+    setSelectedPermissions(rolePermissions);
+}
+
 /**
  * 角色创建结果处理
  */
-void RoleEditor::onCreateRoleResult(bool success, const RoleInfo &role, const QString &error)
+void RoleEditor::onCreateRoleResult(ApiReply *reply)
 {
     m_okButton->setEnabled(true);
     
-    if (success) {
+    if (reply->isSuccess()) {
         showStatus("角色创建成功");
         QMessageBox::information(this, "成功", "角色创建成功！");
         accept();
+    } else if (reply->statusCode() == 0) {
+        showStatus(QString("网络错误: %1").arg(reply->error()), true);
+        QMessageBox::warning(this, "网络错误", QString("网络连接出现问题:\n%1").arg(reply->error()));
     } else {
-        showStatus(QString("创建角色失败: %1").arg(error), true);
-        QMessageBox::warning(this, "错误", QString("创建角色失败:\n%1").arg(error));
+        showStatus(QString("创建角色失败: %1").arg(reply->error()), true);
+        QMessageBox::warning(this, "错误", QString("创建角色失败:\n%1").arg(reply->error()));
     }
 }
 
 /**
  * 角色更新结果处理
  */
-void RoleEditor::onUpdateRoleResult(bool success, const RoleInfo &role, const QString &error)
+void RoleEditor::onUpdateRoleResult(ApiReply *reply)
 {
     m_okButton->setEnabled(true);
     
-    if (success) {
+    if (reply->isSuccess()) {
         showStatus("角色更新成功");
         QMessageBox::information(this, "成功", "角色更新成功！");
         accept();
+    } else if (reply->statusCode() == 0) {
+        showStatus(QString("网络错误: %1").arg(reply->error()), true);
+        QMessageBox::warning(this, "网络错误", QString("网络连接出现问题:\n%1").arg(reply->error()));
     } else {
-        showStatus(QString("更新角色失败: %1").arg(error), true);
-        QMessageBox::warning(this, "错误", QString("更新角色失败:\n%1").arg(error));
+        showStatus(QString("更新角色失败: %1").arg(reply->error()), true);
+        QMessageBox::warning(this, "错误", QString("更新角色失败:\n%1").arg(reply->error()));
     }
-}
-
-/**
- * 网络错误处理
- */
-void RoleEditor::onNetworkError(const QString &error)
-{
-    m_okButton->setEnabled(true);
-    showStatus(QString("网络错误: %1").arg(error), true);
-    QMessageBox::warning(this, "网络错误", QString("网络连接出现问题:\n%1").arg(error));
 }
\ No newline at end of file
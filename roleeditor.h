@@ -51,22 +51,22 @@ private slots:
     /**
      * 权限列表结果处理
      */
-    void onPermissionListResult(bool success, const QList<PermissionInfo> &permissions, const QString &error);
+    void onPermissionListResult(ApiReply *reply);
     
     /**
-     * 角色创建结果处理
+     * 角色详情结果处理
      */
-    void onCreateRoleResult(bool success, const RoleInfo &role, const QString &error);
+    void onRoleDetailResult(ApiReply *reply);
     
     /**
-     * 角色更新结果处理
+     * 角色创建结果处理
      */
-    void onUpdateRoleResult(bool success, const RoleInfo &role, const QString &error);
+    void onCreateRoleResult(ApiReply *reply);
     
     /**
-     * 网络错误处理
+     * 角色更新结果处理
      */
-    void onNetworkError(const QString &error);
+    void onUpdateRoleResult(ApiReply *reply);
 
 private:
     /**
@@ -84,6 +84,11 @@ private:
      */
     void loadPermissions();
     
+    /**
+     * 加载角色详情（角色列表只含权限数量，已分配的权限在打开编辑器时加载）
+     */
+    void loadRoleDetail();
+    
     /**
      * 验证输入
      */
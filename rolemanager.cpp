@@ -1,11 +1,11 @@
 #include "rolemanager.h"
 #include "roleeditor.h"
+#include "entitystore.h"
 #include <QMessageBox>
 #include <QGridLayout>
 #include <QSplitter>
 #include <QGroupBox>
 #include <QHeaderView>
-#include <QShowEvent>
 
 /**
  * 构造函数
@@ -29,14 +29,6 @@ RoleManager::RoleManager(ApiManager *apiManager, QWidget *parent)
     setupStyles();
     setupTable();
     
-    // 连接API管理器信号
-    connect(m_apiManager, &ApiManager::roleListResult, this, &RoleManager::onRoleListResult);
-    connect(m_apiManager, &ApiManager::roleInfoResult, this, &RoleManager::onRoleInfoResult);
-    connect(m_apiManager, &ApiManager::createRoleResult, this, &RoleManager::onCreateRoleResult);
-    connect(m_apiManager, &ApiManager::updateRoleResult, this, &RoleManager::onUpdateRoleResult);
-    connect(m_apiManager, &ApiManager::deleteRoleResult, this, &RoleManager::onDeleteRoleResult);
-    connect(m_apiManager, &ApiManager::networkError, this, &RoleManager::onNetworkError);
-    
     // 连接按钮信号
     connect(m_addButton, &QPushButton::clicked, this, &RoleManager::onAddRoleClicked);
     connect(m_editButton, &QPushButton::clicked, this, &RoleManager::onEditRoleClicked);
@@ -48,6 +40,10 @@ RoleManager::RoleManager(ApiManager *apiManager, QWidget *parent)
     connect(m_roleTable, &QTableWidget::itemSelectionChanged, this, &RoleManager::onRoleTableSelectionChanged);
     connect(m_roleTable, &QTableWidget::cellDoubleClicked, this, &RoleManager::onRoleTableDoubleClicked);
     
+    // 角色目录由同步与推送维护，变化时刷新表格
+    connect(m_apiManager->entityStore(), &EntityStore::rolesChanged,
+            this, &RoleManager::onStoreRolesChanged);
+    
     // 不在构造时加载角色列表，等待登录成功后再加载
     // refreshRoleList();
 }
@@ -60,15 +56,23 @@ RoleManager::~RoleManager()
 }
 
 /**
- * 显示事件，首次显示时自动加载数据
+ * 页面激活，首次激活时自动加载数据
+ * 页面切走后保持存活，再次激活时直接显示已加载的数据
  */
-void RoleManager::showEvent(QShowEvent *event)
+void RoleManager::activateTool()
 {
-    QWidget::showEvent(event);
-    
     if (m_firstShow) {
         m_firstShow = false;
         refreshRoleList();
+        
+        // 先显示上次保存的快照，服务器数据返回后再替换
+        EntityStore *store = m_apiManager->entityStore();
+        if (store->hasSnapshot() && !store->roles().isEmpty()) {
+            m_roles = store->roles();
+            updateTable();
+            showStatus(QString("显示 %1 的数据，正在同步...")
+                       .arg(store->snapshotTime().toString("yyyy-MM-dd hh:mm")));
+        }
     }
 }
 
@@ -242,7 +246,15 @@ void RoleManager::setupTable()
 void RoleManager::refreshRoleList()
 {
     showStatus("正在加载角色列表...");
-    m_apiManager->getRoleList();
+    
+    // 新的刷新取代尚未返回的旧请求
+    if (m_roleListReply) {
+        m_roleListReply->cancel();
+    }
+    m_roleListReply = m_apiManager->syncRoles(ApiManager::Interactive);
+    m_roleListReply->then(this, [this](ApiReply *reply) {
+        onRoleListResult(reply);
+    });
 }
 
 /**
@@ -258,7 +270,7 @@ void RoleManager::updateTable()
         m_roleTable->setItem(i, 0, new QTableWidgetItem(QString::number(role.id)));
         m_roleTable->setItem(i, 1, new QTableWidgetItem(role.name));
         m_roleTable->setItem(i, 2, new QTableWidgetItem(role.description));
-        m_roleTable->setItem(i, 3, new QTableWidgetItem(QString::number(role.permissions.size())));
+        m_roleTable->setItem(i, 3, new QTableWidgetItem(QString::number(role.permissionCount)));
         m_roleTable->setItem(i, 4, new QTableWidgetItem(role.createdAt));
         m_roleTable->setItem(i, 5, new QTableWidgetItem(role.updatedAt));
         
@@ -354,7 +366,9 @@ void RoleManager::onDeleteRoleClicked()
     
     if (ret == QMessageBox::Yes) {
         showStatus("正在删除角色...");
-        m_apiManager->deleteRole(role.id);
+        m_apiManager->deleteRole(role.id)->then(this, [this](ApiReply *reply) {
+            onDeleteRoleResult(reply);
+        });
     }
 }
 
@@ -363,6 +377,8 @@ void RoleManager::onDeleteRoleClicked()
  */
 void RoleManager::onRefreshClicked()
 {
+    // 手动刷新跳过缓存，直接从服务器获取最新数据
+    m_apiManager->invalidateCache("/roles/");
     refreshRoleList();
 }
 
@@ -398,76 +414,43 @@ void RoleManager::onSearchClicked()
 /**
  * 角色列表结果处理
  */
-void RoleManager::onRoleListResult(bool success, const QList<RoleInfo> &roles, const QString &error)
+void RoleManager::onRoleListResult(ApiReply *reply)
 {
-    if (success) {
-        m_roles = roles;
-        updateTable();
+    if (reply->isSuccess()) {
+        // 表格已在onStoreRolesChanged中更新
         showStatus("角色列表加载完成");
     } else {
-        showStatus(QString("加载角色列表失败: %1").arg(error), true);
-    }
-}
-
-/**
- * 角色信息结果处理
- */
-void RoleManager::onRoleInfoResult(bool success, const RoleInfo &role, const QString &error)
-{
-    if (success) {
-        showStatus("角色信息获取成功");
-    } else {
-        showStatus(QString("获取角色信息失败: %1").arg(error), true);
+        showStatus(QString("加载角色列表失败: %1").arg(reply->error()), true);
     }
 }
 
 /**
- * 角色创建结果处理
+ * 本地存储中的角色目录变化
+ * 正在搜索时保持搜索结果
  */
-void RoleManager::onCreateRoleResult(bool success, const RoleInfo &role, const QString &error)
+void RoleManager::onStoreRolesChanged()
 {
-    if (success) {
-        showStatus("角色创建成功");
-        refreshRoleList();
-    } else {
-        showStatus(QString("创建角色失败: %1").arg(error), true);
-    }
-}
-
-/**
- * 角色更新结果处理
- */
-void RoleManager::onUpdateRoleResult(bool success, const RoleInfo &role, const QString &error)
-{
-    if (success) {
-        showStatus("角色更新成功");
-        refreshRoleList();
+    m_roles = m_apiManager->entityStore()->roles();
+    if (m_searchEdit->text().trimmed().isEmpty()) {
+        updateTable();
     } else {
-        showStatus(QString("更新角色失败: %1").arg(error), true);
+        onSearchClicked();
     }
 }
 
 /**
  * 角色删除结果处理
  */
-void RoleManager::onDeleteRoleResult(bool success, const QString &message)
+void RoleManager::onDeleteRoleResult(ApiReply *reply)
 {
-    if (success) {
+    if (reply->isSuccess()) {
         showStatus("角色删除成功");
         refreshRoleList();
     } else {
-        showStatus(QString("删除角色失败: %1").arg(message), true);
+        showStatus(QString("删除角色失败: %1").arg(reply->error()), true);
     }
 }
 
-/**
- * 网络错误处理
- */
-void RoleManager::onNetworkError(const QString &error)
-{
-    showStatus(QString("网络错误: %1").arg(error), true);
-}
-
 /**
  * 表格选择变化事件
  */
@@ -10,21 +10,23 @@
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QMessageBox>
+#include <QPointer>
 #include "apimanager.h"
+#include "itool.h"
 
-class RoleManager : public QWidget
+class RoleManager : public QWidget, public IToolPage
 {
     Q_OBJECT
+    Q_INTERFACES(IToolPage)
 
 public:
     explicit RoleManager(ApiManager *apiManager, QWidget *parent = nullptr);
     ~RoleManager();
 
-protected:
     /**
-     * 显示事件，首次显示时自动加载数据
+     * 页面激活，首次激活时自动加载数据
      */
-    void showEvent(QShowEvent *event) override;
+    void activateTool() override;
 
 public slots:
     /**
@@ -61,32 +63,17 @@ private slots:
     /**
      * 角色列表结果处理
      */
-    void onRoleListResult(bool success, const QList<RoleInfo> &roles, const QString &error);
-    
-    /**
-     * 角色信息结果处理
-     */
-    void onRoleInfoResult(bool success, const RoleInfo &role, const QString &error);
-    
-    /**
-     * 角色创建结果处理
-     */
-    void onCreateRoleResult(bool success, const RoleInfo &role, const QString &error);
-    
-    /**
-     * 角色更新结果处理
-     */
-    void onUpdateRoleResult(bool success, const RoleInfo &role, const QString &error);
+    void onRoleListResult(ApiReply *reply);
     
     /**
      * 角色删除结果处理
      */
-    void onDeleteRoleResult(bool success, const QString &message);
+    void onDeleteRoleResult(ApiReply *reply);
     
     /**
-     * 网络错误处理
+     * 本地存储中的角色目录变化（同步或推送）
      */
-    void onNetworkError(const QString &error);
+    void onStoreRolesChanged();
     
     /**
      * 表格选择变化事件
@@ -154,6 +141,7 @@ private:
     // 数据
     ApiManager *m_apiManager;
     QList<RoleInfo> m_roles;
+    QPointer<ApiReply> m_roleListReply;
     int m_totalRoles;
     bool m_firstShow;
 };
@@ -0,0 +1,184 @@
+#ifndef HTTPSTUB_H
+#define HTTPSTUB_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <functional>
+#include <memory>
+
+/**
+ * 测试用的最小HTTP/1.1服务端
+ * 在本机回环地址上监听，按处理函数生成响应；支持长连接与管线化（同一连接上的响应按请求顺序发出）。
+ * 响应可以延迟发出或永不发出，用于观察客户端的并发、重试、合并与超时行为
+ */
+class HttpStub : public QObject
+{
+public:
+    struct Request {
+        QByteArray method;
+        QByteArray path;                        // 含查询参数
+        QHash<QByteArray, QByteArray> headers;  // 名称为小写
+        QByteArray body;
+    };
+    
+    struct Response {
+        int status = 200;
+        QByteArray body = "{}";
+        QByteArray contentType = "application/json";
+        QList<QPair<QByteArray, QByteArray>> headers;
+        int delayMs = 0;                        // 延迟发出，小于0表示永不发出
+    };
+    
+    using Handler = std::function<Response(const Request &)>;
+    
+    explicit HttpStub(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+    
+    bool listen() { return m_server.listen(QHostAddress::LocalHost); }
+    
+    // API基础地址，与客户端配置的server/url格式一致
+    QString baseUrl(const QString &scheme = QStringLiteral("http")) const
+    {
+        return QString("%1://127.0.0.1:%2/api").arg(scheme).arg(m_server.serverPort());
+    }
+    
+    void setHandler(const Handler &handler) { m_handler = handler; }
+    
+    // 方法相同且路径以prefix开头的请求数
+    int count(const QByteArray &method, const QByteArray &prefix) const
+    {
+        int n = 0;
+        for (const Request &request : requests) {
+            if (request.method == method && request.path.startsWith(prefix)) {
+                n++;
+            }
+        }
+        return n;
+    }
+    
+    // 已收到的请求（按到达顺序）
+    QList<Request> requests;
+    
+    // 已收到但尚未响应的请求数，及其出现过的最大值
+    int pending = 0;
+    int maxPending = 0;
+
+private:
+    // 同一连接上按请求顺序排队的响应
+    struct Slot {
+        bool ready = false;
+        QByteArray data;
+    };
+    struct Connection {
+        QByteArray buffer;
+        QList<std::shared_ptr<Slot>> queue;
+    };
+    
+    void accept(QTcpSocket *socket)
+    {
+        auto connection = std::make_shared<Connection>();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket, connection]() {
+            process(socket, connection);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+    
+    // 从缓冲区中解析出完整的请求并逐个响应；不是HTTP请求（如TLS握手）时不做任何响应
+    void process(QTcpSocket *socket, const std::shared_ptr<Connection> &connection)
+    {
+        connection->buffer += socket->readAll();
+        for (;;) {
+            int headerEnd = connection->buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                return;
+            }
+            
+            QList<QByteArray> lines = connection->buffer.left(headerEnd).split('\n');
+            QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+            if (requestLine.size() != 3 || !requestLine[2].startsWith("HTTP/")) {
+                connection->buffer.clear();
+                return;
+            }
+            
+            Request request;
+            request.method = requestLine[0];
+            request.path = requestLine[1];
+            for (int i = 1; i < lines.size(); ++i) {
+                QByteArray line = lines[i].trimmed();
+                int colon = line.indexOf(':');
+                if (colon > 0) {
+                    request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+                }
+            }
+            
+            int length = request.headers.value("content-length").toInt();
+            if (connection->buffer.size() < headerEnd + 4 + length) {
+                return;
+            }
+            request.body = connection->buffer.mid(headerEnd + 4, length);
+            connection->buffer.remove(0, headerEnd + 4 + length);
+            respond(socket, connection, request);
+        }
+    }
+    
+    void respond(QTcpSocket *socket, const std::shared_ptr<Connection> &connection, const Request &request)
+    {
+        requests.append(request);
+        pending++;
+        maxPending = qMax(maxPending, pending);
+        
+        Response response = m_handler ? m_handler(request) : Response();
+        auto slot = std::make_shared<Slot>();
+        connection->queue.append(slot);
+        if (response.delayMs < 0) {
+            return;
+        }
+        
+        QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status)
+                          + (response.status < 400 ? " OK\r\n" : " Error\r\n");
+        data += "Content-Type: " + response.contentType + "\r\n";
+        data += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+        for (const QPair<QByteArray, QByteArray> &header : std::as_const(response.headers)) {
+            data += header.first + ": " + header.second + "\r\n";
+        }
+        data += "\r\n" + response.body;
+        
+        QPointer<QTcpSocket> target(socket);
+        auto send = [this, target, connection, slot, data]() {
+            slot->data = data;
+            slot->ready = true;
+            pending--;
+            while (!connection->queue.isEmpty() && connection->queue.first()->ready) {
+                if (target) {
+                    target->write(connection->queue.first()->data);
+                }
+                connection->queue.removeFirst();
+            }
+        };
+        if (response.delayMs == 0) {
+            send();
+        } else {
+            QTimer::singleShot(response.delayMs, this, send);
+        }
+    }
+    
+    QTcpServer m_server;
+    Handler m_handler;
+};
+
+#endif // HTTPSTUB_H
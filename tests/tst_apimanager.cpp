@@ -0,0 +1,372 @@
+#include <QtTest>
+#include <QNetworkProxy>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <memory>
+#include "apimanager.h"
+#include "httpstub.h"
+
+/**
+ * ApiManager单元测试（请求合并、重试与重试预算、请求优先级、批量操作）
+ * 每个用例对本机测试服务端新建ApiManager，配置写入临时目录中的设置文件
+ */
+class TestApiManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void coalescesIdenticalGets();
+    void doesNotCoalesceAcrossTokens();
+    void canceledSubscriberDoesNotCancelOthers();
+    void retriesTransientFailures();
+    void doesNotRetryLogin();
+    void retryBudgetLimitsRetries();
+    void interactiveOvertakesBackgroundBatch();
+    void interactiveBatchOvertakesBackgroundBatch();
+    void batchFallbackKeepsConcurrencyLimit();
+    void batchEnvelopeRetriesTransientOperation();
+
+private:
+    // 句柄的完成结果（句柄完成后自行释放，结果在完成时复制出来）
+    struct Outcome {
+        bool finished = false;
+        ApiResult result;
+    };
+    static std::shared_ptr<Outcome> track(ApiReply *reply);
+    
+    // 按当前设置新建连接到测试服务端的ApiManager
+    static ApiManager *createManager(const HttpStub &stub);
+    
+    // 总是返回503且允许立即重试的处理函数
+    static HttpStub::Response unavailable(const HttpStub::Request &request);
+    
+    // 停用ID从first开始的count个用户的批量操作
+    static QList<BatchOperation> deactivateUsers(int first, int count);
+    
+    // 两个连接、为交互请求保留一个，用户更新延迟完成，后台批次每次只有一个请求在途
+    static void setUpSingleBackgroundConnection(HttpStub &stub);
+    
+    QTemporaryDir m_settingsDir;
+};
+
+std::shared_ptr<TestApiManager::Outcome> TestApiManager::track(ApiReply *reply)
+{
+    auto outcome = std::make_shared<Outcome>();
+    connect(reply, &ApiReply::finished, reply, [reply, outcome]() {
+        outcome->finished = true;
+        outcome->result = reply->result();
+    });
+    return outcome;
+}
+
+ApiManager *TestApiManager::createManager(const HttpStub &stub)
+{
+    ApiManager *manager = new ApiManager();
+    manager->setBaseUrl(stub.baseUrl());
+    manager->setAuthToken("token-a");
+    return manager;
+}
+
+HttpStub::Response TestApiManager::unavailable(const HttpStub::Request &)
+{
+    HttpStub::Response response;
+    response.status = 503;
+    response.body = R"({"detail": "unavailable"})";
+    response.headers.append(qMakePair(QByteArray("Retry-After"), QByteArray("0")));
+    return response;
+}
+
+QList<BatchOperation> TestApiManager::deactivateUsers(int first, int count)
+{
+    QList<BatchOperation> operations;
+    for (int userId = first; userId < first + count; ++userId) {
+        BatchOperation operation{BatchOperation::SetUserActive, userId, 0, false};
+        operations.append(operation);
+    }
+    return operations;
+}
+
+void TestApiManager::setUpSingleBackgroundConnection(HttpStub &stub)
+{
+    QSettings settings;
+    settings.setValue("network/max_connections", 2);
+    settings.setValue("network/interactive_reserve", 1);
+    settings.setValue("network/batch_envelope", false);
+    stub.setHandler([](const HttpStub::Request &request) {
+        HttpStub::Response response;
+        response.body = R"({"id": 1, "username": "alice"})";
+        if (request.method == "PUT") {
+            response.delayMs = 300;
+        }
+        return response;
+    });
+}
+
+void TestApiManager::initTestCase()
+{
+    // 设置、快照与缓存都写入测试专用位置，本机测试服务端不经过系统代理
+    QVERIFY(m_settingsDir.isValid());
+    QStandardPaths::setTestModeEnabled(true);
+    QCoreApplication::setOrganizationName("dbatools-tests");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, m_settingsDir.path());
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+}
+
+void TestApiManager::init()
+{
+    // 关闭响应缓存、压缩、CBOR与重试，各用例只打开要验证的功能
+    QSettings settings;
+    settings.clear();
+    settings.setValue("cache/users_ttl", 0);
+    settings.setValue("cache/roles_ttl", 0);
+    settings.setValue("cache/permissions_ttl", 0);
+    settings.setValue("network/http2", false);
+    settings.setValue("network/tls_session_reuse", false);
+    settings.setValue("network/compress_requests", false);
+    settings.setValue("network/accept_cbor", false);
+    settings.setValue("network/field_projection", false);
+    settings.setValue("network/retry_count", 0);
+}
+
+void TestApiManager::coalescesIdenticalGets()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.body = R"({"id": 1, "username": "alice"})";
+        response.delayMs = 200;
+        return response;
+    });
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 相同的GET在途时只发出一次，结果送达每个调用方
+    auto first = track(manager->getCurrentUserInfo());
+    auto second = track(manager->getCurrentUserInfo());
+    QTRY_VERIFY(first->finished && second->finished);
+    QCOMPARE(stub.count("GET", "/api/users/me"), 1);
+    QVERIFY(first->result.success);
+    QVERIFY(second->result.success);
+    QCOMPARE(first->result.value.value<UserInfo>().username, QStringLiteral("alice"));
+    QCOMPARE(second->result.value.value<UserInfo>().username, QStringLiteral("alice"));
+    
+    // 前一个请求完成后，相同的GET重新发出
+    auto third = track(manager->getCurrentUserInfo());
+    QTRY_VERIFY(third->finished);
+    QCOMPARE(stub.count("GET", "/api/users/me"), 2);
+}
+
+void TestApiManager::doesNotCoalesceAcrossTokens()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.delayMs = 200;
+        return response;
+    });
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 不同令牌的结果可能不同，不能合并
+    auto first = track(manager->getCurrentUserInfo());
+    manager->setAuthToken("token-b");
+    auto second = track(manager->getCurrentUserInfo());
+    QTRY_VERIFY(first->finished && second->finished);
+    QCOMPARE(stub.count("GET", "/api/users/me"), 2);
+    QCOMPARE(stub.requests[0].headers.value("authorization"), QByteArray("Bearer token-a"));
+    QCOMPARE(stub.requests[1].headers.value("authorization"), QByteArray("Bearer token-b"));
+}
+
+void TestApiManager::canceledSubscriberDoesNotCancelOthers()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.body = R"({"id": 1, "username": "alice"})";
+        response.delayMs = 200;
+        return response;
+    });
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 取消其中一个调用方只移除该调用方，合并的请求继续进行
+    ApiReply *canceled = manager->getCurrentUserInfo();
+    auto kept = track(manager->getCurrentUserInfo());
+    canceled->cancel();
+    QTRY_VERIFY(kept->finished);
+    QVERIFY(kept->result.success);
+    QCOMPARE(stub.count("GET", "/api/users/me"), 1);
+}
+
+void TestApiManager::retriesTransientFailures()
+{
+    QSettings().setValue("network/retry_count", 3);
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler(unavailable);
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 503按Retry-After立即重试，用完重试次数后把最后一次的错误交给调用方
+    auto outcome = track(manager->getCurrentUserInfo());
+    QTRY_VERIFY(outcome->finished);
+    QCOMPARE(stub.count("GET", "/api/users/me"), 4);
+    QVERIFY(!outcome->result.success);
+    QCOMPARE(outcome->result.statusCode, 503);
+}
+
+void TestApiManager::doesNotRetryLogin()
+{
+    QSettings().setValue("network/retry_count", 3);
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler(unavailable);
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 登录不是幂等请求，不自动重试
+    auto outcome = track(manager->login("alice", "secret"));
+    QTRY_VERIFY(outcome->finished);
+    QCOMPARE(stub.count("POST", "/api/auth/login"), 1);
+    QCOMPARE(outcome->result.statusCode, 503);
+}
+
+void TestApiManager::retryBudgetLimitsRetries()
+{
+    QSettings().setValue("network/retry_count", 3);
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler(unavailable);
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 预算已满时新请求不再补充额度，30个请求共用初始的10次重试，而不是各重试3次
+    QList<std::shared_ptr<Outcome>> outcomes;
+    for (int i = 1; i <= 30; ++i) {
+        outcomes.append(track(manager->getUserInfo(i)));
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(std::all_of(outcomes.cbegin(), outcomes.cend(),
+                                         [](const std::shared_ptr<Outcome> &outcome) { return outcome->finished; }),
+                             10000);
+    QCOMPARE(stub.count("GET", "/api/users/"), 40);
+    for (const std::shared_ptr<Outcome> &outcome : std::as_const(outcomes)) {
+        QCOMPARE(outcome->result.statusCode, 503);
+    }
+}
+
+void TestApiManager::interactiveOvertakesBackgroundBatch()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    setUpSingleBackgroundConnection(stub);
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 后台批次占满后台可用的连接，其余操作排队；交互请求使用保留的连接，不排在后台操作之后
+    auto batch = track(manager->submitBatch(deactivateUsers(1, 4)));
+    QTRY_COMPARE(stub.requests.size(), 1);
+    auto user = track(manager->getCurrentUserInfo());
+    QTRY_COMPARE(stub.requests.size(), 2);
+    QCOMPARE(stub.requests[1].method, QByteArray("GET"));
+    QCOMPARE(stub.requests[1].path, QByteArray("/api/users/me"));
+    
+    QTRY_VERIFY(user->finished);
+    QVERIFY(user->result.success);
+    QCOMPARE(stub.count("PUT", "/api/users/"), 1);
+    QTRY_VERIFY_WITH_TIMEOUT(batch->finished, 10000);
+    QVERIFY(batch->result.success);
+    QCOMPARE(stub.count("PUT", "/api/users/"), 4);
+}
+
+void TestApiManager::interactiveBatchOvertakesBackgroundBatch()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    setUpSingleBackgroundConnection(stub);
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 编辑器保存使用交互优先级提交，不等待正在进行的后台批次
+    auto background = track(manager->submitBatch(deactivateUsers(1, 4)));
+    QTRY_COMPARE(stub.requests.size(), 1);
+    auto interactive = track(manager->submitBatch(deactivateUsers(10, 1), ApiManager::Interactive));
+    QTRY_COMPARE(stub.requests.size(), 2);
+    QCOMPARE(stub.requests[1].path, QByteArray("/api/users/10"));
+    
+    QTRY_VERIFY(interactive->finished);
+    QVERIFY(interactive->result.success);
+    QTRY_VERIFY_WITH_TIMEOUT(background->finished, 10000);
+    QVERIFY(background->result.success);
+}
+
+void TestApiManager::batchFallbackKeepsConcurrencyLimit()
+{
+    QSettings settings;
+    settings.setValue("network/max_connections", 8);
+    settings.setValue("network/interactive_reserve", 0);
+    settings.setValue("network/batch_envelope", true);
+    settings.setValue("network/batch_size", 3);
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &request) {
+        HttpStub::Response response;
+        if (request.path == "/api/batch") {
+            response.status = 404;
+            response.body = R"({"detail": "Not Found"})";
+        } else {
+            response.delayMs = 100;
+        }
+        return response;
+    });
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 服务端没有批量接口时，已打包的操作放回批次队列逐个发出，仍受批次的并发上限约束
+    auto outcome = track(manager->submitBatch(deactivateUsers(1, 7), ApiManager::Background, 2));
+    QTRY_VERIFY_WITH_TIMEOUT(outcome->finished, 10000);
+    QVERIFY(outcome->result.success);
+    QVERIFY(outcome->result.value.value<BatchResult>().failed.isEmpty());
+    
+    int envelopes = stub.count("POST", "/api/batch");
+    QVERIFY(envelopes >= 1 && envelopes <= 2);
+    QCOMPARE(stub.count("PUT", "/api/users/"), 7);
+    QSet<QByteArray> paths;
+    for (const HttpStub::Request &request : std::as_const(stub.requests)) {
+        if (request.method == "PUT") {
+            paths.insert(request.path);
+        }
+    }
+    QCOMPARE(paths.size(), 7);
+    QVERIFY(stub.maxPending <= 2);
+}
+
+void TestApiManager::batchEnvelopeRetriesTransientOperation()
+{
+    QSettings().setValue("network/batch_envelope", true);
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &request) {
+        HttpStub::Response response;
+        if (request.path == "/api/batch") {
+            response.body = R"({"results": [)"
+                            R"({"id": 0, "status": 503, "body": {"detail": "unavailable"}},)"
+                            R"({"id": 1, "status": 200, "body": {}},)"
+                            R"({"id": 2, "status": 200, "body": {}}]})";
+        }
+        return response;
+    });
+    std::unique_ptr<ApiManager> manager(createManager(stub));
+    
+    // 批量响应中单项的临时故障只重发该项，其余项按成功计入
+    auto outcome = track(manager->submitBatch(deactivateUsers(1, 3)));
+    QTRY_VERIFY(outcome->finished);
+    QVERIFY(outcome->result.success);
+    QVERIFY(outcome->result.value.value<BatchResult>().failed.isEmpty());
+    QCOMPARE(stub.count("POST", "/api/batch"), 1);
+    QCOMPARE(stub.count("PUT", "/api/users/"), 1);
+    QCOMPARE(stub.count("PUT", "/api/users/1"), 1);
+}
+
+QTEST_GUILESS_MAIN(TestApiManager)
+
+#include "tst_apimanager.moc"
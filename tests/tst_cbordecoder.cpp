@@ -0,0 +1,233 @@
+#include <QtTest>
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include "cbordecoder.h"
+
+/**
+ * CborDecoder单元测试
+ */
+class TestCborDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void isCbor();
+    void decodeUsersFromArray();
+    void decodeUsersFromItemsObject();
+    void decodeRolesPermissionCount();
+    void decodePermissions();
+    void decodeUserSyncPage();
+    void decodeRoleSyncPage();
+    void syncPageWithoutDeletedIds();
+    void rejectsMalformedData();
+    void toJsonDocument();
+
+private:
+    static QCborMap userMap(int id, const QString &username);
+};
+
+/**
+ * 构造一个用户对象
+ */
+QCborMap TestCborDecoder::userMap(int id, const QString &username)
+{
+    QCborMap user;
+    user.insert(QStringLiteral("id"), id);
+    user.insert(QStringLiteral("username"), username);
+    user.insert(QStringLiteral("email"), username + "@example.com");
+    user.insert(QStringLiteral("full_name"), QCborValue(QCborValue::Null));
+    user.insert(QStringLiteral("is_active"), true);
+    user.insert(QStringLiteral("updated_at"), QStringLiteral("2024-05-01T10:00:00Z"));
+    return user;
+}
+
+void TestCborDecoder::isCbor()
+{
+    QVERIFY(CborDecoder::isCbor("application/cbor"));
+    QVERIFY(CborDecoder::isCbor(" Application/CBOR; charset=binary"));
+    QVERIFY(!CborDecoder::isCbor("application/json"));
+    QVERIFY(!CborDecoder::isCbor(QByteArray()));
+}
+
+void TestCborDecoder::decodeUsersFromArray()
+{
+    QCborMap first = userMap(1, "alice");
+    QCborArray roles;
+    roles.append(QStringLiteral("admin"));
+    QCborMap roleObject;
+    roleObject.insert(QStringLiteral("id"), 2);
+    roleObject.insert(QStringLiteral("name"), QStringLiteral("auditor"));
+    roles.append(roleObject);
+    first.insert(QStringLiteral("roles"), roles);
+    
+    // 未知字段（包括嵌套容器）应被跳过
+    QCborMap extra;
+    extra.insert(QStringLiteral("nested"), QCborArray{1, 2, 3});
+    first.insert(QStringLiteral("extra"), extra);
+    
+    QCborArray items{first, userMap(2, "bob")};
+    QList<UserInfo> users;
+    QVERIFY(CborDecoder::decodeUsers(QCborValue(items).toCbor(), &users));
+    
+    QCOMPARE(users.size(), 2);
+    QCOMPARE(users[0].id, 1);
+    QCOMPARE(users[0].username, QStringLiteral("alice"));
+    QCOMPARE(users[0].email, QStringLiteral("alice@example.com"));
+    QVERIFY(users[0].fullName.isEmpty());
+    QVERIFY(users[0].isActive);
+    QCOMPARE(users[0].updatedAt, QStringLiteral("2024-05-01T10:00:00Z"));
+    QCOMPARE(users[0].roles, QStringList({"admin", "auditor"}));
+    QCOMPARE(users[1].id, 2);
+    QCOMPARE(users[1].username, QStringLiteral("bob"));
+}
+
+void TestCborDecoder::decodeUsersFromItemsObject()
+{
+    QCborMap page;
+    page.insert(QStringLiteral("total"), 1);
+    page.insert(QStringLiteral("items"), QCborArray{userMap(7, "carol")});
+    
+    // 带自描述标记（55799）
+    QCborValue tagged(QCborKnownTags::Signature, page);
+    QList<UserInfo> users;
+    QVERIFY(CborDecoder::decodeUsers(tagged.toCbor(), &users));
+    QCOMPARE(users.size(), 1);
+    QCOMPARE(users[0].id, 7);
+    QCOMPARE(users[0].username, QStringLiteral("carol"));
+}
+
+void TestCborDecoder::decodeRolesPermissionCount()
+{
+    QCborMap permission;
+    permission.insert(QStringLiteral("id"), 11);
+    permission.insert(QStringLiteral("name"), QStringLiteral("user.read"));
+    
+    // 带权限明细时以明细数量为准
+    QCborMap detailed;
+    detailed.insert(QStringLiteral("id"), 1);
+    detailed.insert(QStringLiteral("name"), QStringLiteral("admin"));
+    detailed.insert(QStringLiteral("permission_count"), 9);
+    detailed.insert(QStringLiteral("permissions"), QCborArray{permission});
+    
+    // 投影后的列表只给出permission_count
+    QCborMap projected;
+    projected.insert(QStringLiteral("id"), 2);
+    projected.insert(QStringLiteral("name"), QStringLiteral("viewer"));
+    projected.insert(QStringLiteral("display_name"), QStringLiteral("只读用户"));
+    projected.insert(QStringLiteral("permission_count"), 4);
+    
+    QList<RoleInfo> roles;
+    QVERIFY(CborDecoder::decodeRoles(QCborValue(QCborArray{detailed, projected}).toCbor(), &roles));
+    QCOMPARE(roles.size(), 2);
+    QCOMPARE(roles[0].permissions.size(), 1);
+    QCOMPARE(roles[0].permissions[0].name, QStringLiteral("user.read"));
+    QCOMPARE(roles[0].permissionCount, 1);
+    QVERIFY(roles[1].permissions.isEmpty());
+    QCOMPARE(roles[1].permissionCount, 4);
+    QCOMPARE(roles[1].displayName, QStringLiteral("只读用户"));
+}
+
+void TestCborDecoder::decodePermissions()
+{
+    QCborMap permission;
+    permission.insert(QStringLiteral("id"), 3);
+    permission.insert(QStringLiteral("name"), QStringLiteral("role.write"));
+    permission.insert(QStringLiteral("resource"), QStringLiteral("role"));
+    permission.insert(QStringLiteral("action"), QStringLiteral("write"));
+    
+    QList<PermissionInfo> permissions;
+    QVERIFY(CborDecoder::decodePermissions(QCborValue(QCborArray{permission}).toCbor(), &permissions));
+    QCOMPARE(permissions.size(), 1);
+    QCOMPARE(permissions[0].id, 3);
+    QCOMPARE(permissions[0].resource, QStringLiteral("role"));
+    QCOMPARE(permissions[0].action, QStringLiteral("write"));
+}
+
+void TestCborDecoder::decodeUserSyncPage()
+{
+    QCborMap page;
+    page.insert(QStringLiteral("items"), QCborArray{userMap(1, "alice"), userMap(5, "eve")});
+    page.insert(QStringLiteral("deleted_ids"), QCborArray{3, 4});
+    page.insert(QStringLiteral("watermark"), QStringLiteral("2024-05-01T10:00:00Z"));
+    
+    SyncPage result;
+    QVERIFY(CborDecoder::decodeUserSyncPage(QCborValue(page).toCbor(), &result));
+    QCOMPARE(result.users.size(), 2);
+    QCOMPARE(result.users[1].username, QStringLiteral("eve"));
+    QVERIFY(result.roles.isEmpty());
+    QVERIFY(result.hasDeletedIds);
+    QCOMPARE(result.deletedIds, QList<int>({3, 4}));
+}
+
+void TestCborDecoder::decodeRoleSyncPage()
+{
+    QCborMap role;
+    role.insert(QStringLiteral("id"), 2);
+    role.insert(QStringLiteral("name"), QStringLiteral("viewer"));
+    
+    // 没有变化时items与deleted_ids都可以为空
+    QCborMap page;
+    page.insert(QStringLiteral("deleted_ids"), QCborArray());
+    page.insert(QStringLiteral("items"), QCborArray{role});
+    
+    SyncPage result;
+    QVERIFY(CborDecoder::decodeRoleSyncPage(QCborValue(page).toCbor(), &result));
+    QCOMPARE(result.roles.size(), 1);
+    QCOMPARE(result.roles[0].name, QStringLiteral("viewer"));
+    QVERIFY(result.users.isEmpty());
+    QVERIFY(result.hasDeletedIds);
+    QVERIFY(result.deletedIds.isEmpty());
+}
+
+void TestCborDecoder::syncPageWithoutDeletedIds()
+{
+    // 服务端忽略updated_since时返回完整列表，不能当作增量
+    SyncPage fromArray;
+    QVERIFY(CborDecoder::decodeUserSyncPage(QCborValue(QCborArray{userMap(1, "alice")}).toCbor(), &fromArray));
+    QCOMPARE(fromArray.users.size(), 1);
+    QVERIFY(!fromArray.hasDeletedIds);
+    
+    QCborMap page;
+    page.insert(QStringLiteral("items"), QCborArray{userMap(1, "alice")});
+    SyncPage fromObject;
+    QVERIFY(CborDecoder::decodeUserSyncPage(QCborValue(page).toCbor(), &fromObject));
+    QVERIFY(!fromObject.hasDeletedIds);
+}
+
+void TestCborDecoder::rejectsMalformedData()
+{
+    QList<UserInfo> users;
+    QVERIFY(!CborDecoder::decodeUsers(QCborValue(42).toCbor(), &users));
+    
+    QByteArray valid = QCborValue(QCborArray{userMap(1, "alice")}).toCbor();
+    QVERIFY(!CborDecoder::decodeUsers(valid.left(valid.size() - 3), &users));
+    
+    // 列表项不是对象
+    QVERIFY(!CborDecoder::decodeUsers(QCborValue(QCborArray{1, 2}).toCbor(), &users));
+    
+    QCborMap page;
+    page.insert(QStringLiteral("items"), QCborArray());
+    page.insert(QStringLiteral("deleted_ids"), QStringLiteral("3,4"));
+    SyncPage result;
+    QVERIFY(!CborDecoder::decodeUserSyncPage(QCborValue(page).toCbor(), &result));
+}
+
+void TestCborDecoder::toJsonDocument()
+{
+    QCborMap error;
+    error.insert(QStringLiteral("detail"), QStringLiteral("角色不存在"));
+    
+    QJsonDocument doc;
+    QString errorString;
+    QVERIFY(CborDecoder::toJsonDocument(QCborValue(error).toCbor(), &doc, &errorString));
+    QVERIFY(doc.isObject());
+    QCOMPARE(doc.object()["detail"].toString(), QStringLiteral("角色不存在"));
+    
+    QVERIFY(!CborDecoder::toJsonDocument(QByteArray("\xa1", 1), &doc, &errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestCborDecoder)
+
+#include "tst_cbordecoder.moc"
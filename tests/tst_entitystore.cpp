@@ -0,0 +1,254 @@
+#include <QtTest>
+#include <QDir>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include "entitystore.h"
+
+/**
+ * EntityStore单元测试（快照序列化与增量合并）
+ */
+class TestEntityStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void snapshotRoundTrip();
+    void snapshotsAreScopedByServerAndUser();
+    void clearRemovesSnapshot();
+    void mergeUsers();
+    void mergeRolesWithoutChanges();
+    void laterWatermarkComparesTimestamps();
+    void mergeDoesNotMoveWatermarkBack();
+
+private:
+    static UserInfo user(int id, const QString &username);
+    static RoleInfo role(int id, const QString &name);
+};
+
+namespace {
+
+const QString ServerUrl = QStringLiteral("http://localhost:8001/api");
+
+}
+
+UserInfo TestEntityStore::user(int id, const QString &username)
+{
+    UserInfo user;
+    user.id = id;
+    user.username = username;
+    user.email = username + "@example.com";
+    user.fullName = username.toUpper();
+    user.isActive = true;
+    user.createdAt = QStringLiteral("2024-01-01T00:00:00Z");
+    user.updatedAt = QStringLiteral("2024-05-01T10:00:00Z");
+    user.roles = QStringList({"viewer"});
+    return user;
+}
+
+RoleInfo TestEntityStore::role(int id, const QString &name)
+{
+    RoleInfo role;
+    role.id = id;
+    role.name = name;
+    role.displayName = name.toUpper();
+    role.isActive = true;
+    role.updatedAt = QStringLiteral("2024-05-01T10:00:00Z");
+    return role;
+}
+
+void TestEntityStore::initTestCase()
+{
+    // 快照写入测试专用目录，不影响正式数据
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/snapshots").removeRecursively();
+}
+
+void TestEntityStore::cleanupTestCase()
+{
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/snapshots").removeRecursively();
+}
+
+void TestEntityStore::snapshotRoundTrip()
+{
+    PermissionInfo permission;
+    permission.id = 11;
+    permission.name = QStringLiteral("user.read");
+    permission.displayName = QStringLiteral("查看用户");
+    permission.description = QStringLiteral("读取用户列表");
+    permission.resource = QStringLiteral("user");
+    permission.action = QStringLiteral("read");
+    
+    UserInfo admin = user(1, "alice");
+    admin.isSuperuser = true;
+    admin.lastLogin = QStringLiteral("2024-05-02T08:30:00Z");
+    admin.roles = QStringList({"admin", "viewer"});
+    
+    // 权限数与权限明细数量不同（投影后的列表只给出数量），两者都要原样保存
+    RoleInfo detailed = role(1, "admin");
+    detailed.description = QStringLiteral("管理员");
+    detailed.permissions = {permission};
+    detailed.permissionCount = 7;
+    RoleInfo projected = role(2, "viewer");
+    projected.permissionCount = 3;
+    
+    {
+        EntityStore store;
+        store.openSnapshot(ServerUrl, "alice");
+        store.setUsers({admin, user(2, "bob")}, "2024-05-02T08:30:00Z");
+        store.setRoles({detailed, projected}, "2024-05-01T10:00:00Z");
+        store.setPermissions({permission});
+        // 析构时写入尚未保存的更新
+    }
+    
+    EntityStore store;
+    QVERIFY(store.openSnapshot(ServerUrl, "alice"));
+    QVERIFY(store.hasSnapshot());
+    QCOMPARE(store.usersWatermark(), QStringLiteral("2024-05-02T08:30:00Z"));
+    QCOMPARE(store.rolesWatermark(), QStringLiteral("2024-05-01T10:00:00Z"));
+    
+    QCOMPARE(store.users().size(), 2);
+    const UserInfo &loadedUser = store.users()[0];
+    QCOMPARE(loadedUser.id, admin.id);
+    QCOMPARE(loadedUser.username, admin.username);
+    QCOMPARE(loadedUser.email, admin.email);
+    QCOMPARE(loadedUser.fullName, admin.fullName);
+    QCOMPARE(loadedUser.isActive, admin.isActive);
+    QCOMPARE(loadedUser.isSuperuser, admin.isSuperuser);
+    QCOMPARE(loadedUser.createdAt, admin.createdAt);
+    QCOMPARE(loadedUser.updatedAt, admin.updatedAt);
+    QCOMPARE(loadedUser.lastLogin, admin.lastLogin);
+    QCOMPARE(loadedUser.roles, admin.roles);
+    QCOMPARE(store.users()[1].username, QStringLiteral("bob"));
+    
+    QCOMPARE(store.roles().size(), 2);
+    const RoleInfo &loadedRole = store.roles()[0];
+    QCOMPARE(loadedRole.id, detailed.id);
+    QCOMPARE(loadedRole.name, detailed.name);
+    QCOMPARE(loadedRole.displayName, detailed.displayName);
+    QCOMPARE(loadedRole.description, detailed.description);
+    QCOMPARE(loadedRole.updatedAt, detailed.updatedAt);
+    QCOMPARE(loadedRole.permissionCount, 7);
+    QCOMPARE(loadedRole.permissions.size(), 1);
+    QCOMPARE(loadedRole.permissions[0].name, permission.name);
+    QCOMPARE(loadedRole.permissions[0].action, permission.action);
+    QCOMPARE(store.roles()[1].permissionCount, 3);
+    QVERIFY(store.roles()[1].permissions.isEmpty());
+    
+    QCOMPARE(store.permissions().size(), 1);
+    const PermissionInfo &loadedPermission = store.permissions()[0];
+    QCOMPARE(loadedPermission.id, permission.id);
+    QCOMPARE(loadedPermission.displayName, permission.displayName);
+    QCOMPARE(loadedPermission.description, permission.description);
+    QCOMPARE(loadedPermission.resource, permission.resource);
+}
+
+void TestEntityStore::snapshotsAreScopedByServerAndUser()
+{
+    {
+        EntityStore store;
+        store.openSnapshot(ServerUrl, "carol");
+        store.setUsers({user(3, "carol")});
+    }
+    
+    EntityStore store;
+    QVERIFY(!store.openSnapshot(ServerUrl, "dave"));
+    QVERIFY(store.users().isEmpty());
+    QVERIFY(!store.openSnapshot("http://node2:8001/api", "carol"));
+    QVERIFY(store.users().isEmpty());
+    QVERIFY(store.openSnapshot(ServerUrl, "carol"));
+    QCOMPARE(store.users().size(), 1);
+}
+
+void TestEntityStore::clearRemovesSnapshot()
+{
+    {
+        EntityStore store;
+        store.openSnapshot(ServerUrl, "erin");
+        store.setUsers({user(4, "erin")});
+    }
+    
+    {
+        EntityStore store;
+        QVERIFY(store.openSnapshot(ServerUrl, "erin"));
+        store.clear();
+        QVERIFY(!store.hasSnapshot());
+        QVERIFY(store.users().isEmpty());
+    }
+    
+    EntityStore store;
+    QVERIFY(!store.openSnapshot(ServerUrl, "erin"));
+}
+
+void TestEntityStore::mergeUsers()
+{
+    EntityStore store;
+    store.setUsers({user(1, "alice"), user(2, "bob"), user(3, "carol")}, "2024-05-01T10:00:00Z");
+    
+    QSignalSpy spy(&store, &EntityStore::usersChanged);
+    UserInfo renamed = user(2, "robert");
+    renamed.updatedAt = QStringLiteral("2024-05-03T09:00:00Z");
+    store.mergeUsers({user(5, "eve"), renamed}, {1}, "2024-05-03T09:00:00Z");
+    
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(store.usersWatermark(), QStringLiteral("2024-05-03T09:00:00Z"));
+    
+    // 按ID排序，已删除的记录移除，变化的记录原位更新
+    QCOMPARE(store.users().size(), 3);
+    QCOMPARE(store.users()[0].id, 2);
+    QCOMPARE(store.users()[0].username, QStringLiteral("robert"));
+    QCOMPARE(store.users()[1].id, 3);
+    QCOMPARE(store.users()[2].id, 5);
+}
+
+void TestEntityStore::mergeRolesWithoutChanges()
+{
+    EntityStore store;
+    store.setRoles({role(1, "admin")}, "2024-05-01T10:00:00Z");
+    
+    // 没有变化时只推进水位，不通知页面刷新
+    QSignalSpy spy(&store, &EntityStore::rolesChanged);
+    store.mergeRoles({}, {}, "2024-05-04T00:00:00Z");
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(store.rolesWatermark(), QStringLiteral("2024-05-04T00:00:00Z"));
+    QCOMPARE(store.roles().size(), 1);
+}
+
+void TestEntityStore::laterWatermarkComparesTimestamps()
+{
+    // 小数秒位数不同：按字符串比较"10:00:00Z"会大于"10:00:00.500Z"
+    QCOMPARE(EntityStore::laterWatermark("2024-05-01T10:00:00Z", "2024-05-01T10:00:00.500Z"),
+             QStringLiteral("2024-05-01T10:00:00.500Z"));
+    
+    // 时区写法不同：+08:00的11:00早于UTC的10:00
+    QCOMPARE(EntityStore::laterWatermark("2024-05-01T10:00:00Z", "2024-05-01T11:00:00+08:00"),
+             QStringLiteral("2024-05-01T10:00:00Z"));
+    
+    // 返回原字符串，不做格式转换
+    QCOMPARE(EntityStore::laterWatermark("2024-05-02T08:30:00.123456", "2024-05-01T10:00:00"),
+             QStringLiteral("2024-05-02T08:30:00.123456"));
+    
+    // 空水位或无法解析的水位视为最早
+    QCOMPARE(EntityStore::laterWatermark(QString(), "2024-05-01T10:00:00Z"), QStringLiteral("2024-05-01T10:00:00Z"));
+    QCOMPARE(EntityStore::laterWatermark("2024-05-01T10:00:00Z", QString()), QStringLiteral("2024-05-01T10:00:00Z"));
+    QCOMPARE(EntityStore::laterWatermark("not a time", "2024-05-01T10:00:00Z"), QStringLiteral("2024-05-01T10:00:00Z"));
+    QCOMPARE(EntityStore::laterWatermark(QString(), QString()), QString());
+}
+
+void TestEntityStore::mergeDoesNotMoveWatermarkBack()
+{
+    EntityStore store;
+    store.setUsers({user(1, "alice")}, "2024-05-03T09:00:00.250Z");
+    
+    // 较早的增量（例如与同步并发的单条更新）不会让水位后退
+    store.mergeUsers({}, {}, "2024-05-03T09:00:00Z");
+    QCOMPARE(store.usersWatermark(), QStringLiteral("2024-05-03T09:00:00.250Z"));
+    
+    store.mergeUsers({}, {}, "2024-05-03T09:00:01Z");
+    QCOMPARE(store.usersWatermark(), QStringLiteral("2024-05-03T09:00:01Z"));
+}
+
+QTEST_GUILESS_MAIN(TestEntityStore)
+
+#include "tst_entitystore.moc"
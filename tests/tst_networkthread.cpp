@@ -0,0 +1,148 @@
+#include <QtTest>
+#include <QNetworkProxy>
+#ifndef QT_NO_SSL
+#include <QSslSocket>
+#endif
+#include "networkthread.h"
+#include "httpstub.h"
+
+/**
+ * NetworkThread单元测试（超时类型）
+ */
+class TestNetworkThread : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void completedRequestHasNoTimeout();
+    void readTimeout();
+    void totalTimeout();
+    void connectTimeout();
+    void callerAbortIsNotTimeout();
+
+private:
+    // 发出GET请求并等待完成
+    static NetworkCall *get(NetworkThread &thread, const QString &url);
+};
+
+NetworkCall *TestNetworkThread::get(NetworkThread &thread, const QString &url)
+{
+    NetworkCall *call = thread.send("GET", QNetworkRequest(QUrl(url)), QByteArray());
+    QTest::qWaitFor([call]() { return call->isFinished(); }, 10000);
+    return call;
+}
+
+void TestNetworkThread::initTestCase()
+{
+    // 本机测试服务端不经过系统代理
+    QNetworkProxy::setApplicationProxy(QNetworkProxy::NoProxy);
+}
+
+void TestNetworkThread::completedRequestHasNoTimeout()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    
+    NetworkThread thread;
+    thread.setTimeouts(5000, 5000, 5000);
+    NetworkCall *call = get(thread, stub.baseUrl() + "/health");
+    
+    QVERIFY(call->isFinished());
+    QCOMPARE(call->error(), QNetworkReply::NoError);
+    QCOMPARE(call->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    QCOMPARE(call->timeoutKind(), NetworkResponse::NoTimeout);
+    QVERIFY(call->timeoutError().isEmpty());
+}
+
+void TestNetworkThread::readTimeout()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.delayMs = -1;
+        return response;
+    });
+    
+    NetworkThread thread;
+    thread.setTimeouts(0, 0, 200);
+    NetworkCall *call = get(thread, stub.baseUrl() + "/users/me");
+    
+    QVERIFY(call->isFinished());
+    QCOMPARE(call->error(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(call->timeoutKind(), NetworkResponse::ReadTimeout);
+    QVERIFY(!call->timeoutError().isEmpty());
+    QCOMPARE(call->errorString(), call->timeoutError());
+}
+
+void TestNetworkThread::totalTimeout()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.delayMs = -1;
+        return response;
+    });
+    
+    NetworkThread thread;
+    thread.setTimeouts(200, 0, 0);
+    NetworkCall *call = get(thread, stub.baseUrl() + "/users/me");
+    
+    QVERIFY(call->isFinished());
+    QCOMPARE(call->error(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(call->timeoutKind(), NetworkResponse::TotalTimeout);
+}
+
+void TestNetworkThread::connectTimeout()
+{
+#if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
+    QSKIP("连接超时需要Qt 6.3及以上版本（QNetworkReply::requestSent）");
+#elif defined(QT_NO_SSL)
+    QSKIP("没有TLS支持");
+#else
+    if (!QSslSocket::supportsSsl()) {
+        QSKIP("没有可用的TLS后端");
+    }
+    
+    // 测试服务端不响应TLS握手，请求一直停在建立连接阶段
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    
+    NetworkThread thread;
+    thread.setTimeouts(0, 200, 0);
+    NetworkCall *call = get(thread, stub.baseUrl("https") + "/users/me");
+    
+    QVERIFY(call->isFinished());
+    QCOMPARE(call->error(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(call->timeoutKind(), NetworkResponse::ConnectTimeout);
+    QVERIFY(stub.requests.isEmpty());
+#endif
+}
+
+void TestNetworkThread::callerAbortIsNotTimeout()
+{
+    HttpStub stub;
+    QVERIFY(stub.listen());
+    stub.setHandler([](const HttpStub::Request &) {
+        HttpStub::Response response;
+        response.delayMs = -1;
+        return response;
+    });
+    
+    NetworkThread thread;
+    thread.setTimeouts(0, 0, 0);
+    NetworkCall *call = thread.send("GET", QNetworkRequest(QUrl(stub.baseUrl() + "/users/me")), QByteArray());
+    QTRY_COMPARE(stub.requests.size(), 1);
+    call->abort();
+    QTRY_VERIFY(call->isFinished());
+    
+    QCOMPARE(call->error(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(call->timeoutKind(), NetworkResponse::NoTimeout);
+    QVERIFY(call->timeoutError().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestNetworkThread)
+
+#include "tst_networkthread.moc"
@@ -0,0 +1,174 @@
+#include <QtTest>
+#include <QDateTime>
+#include "responsecache.h"
+
+/**
+ * ResponseCache单元测试
+ */
+class TestResponseCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ttlUsesLongestPrefix();
+    void storeAndLookup();
+    void pathsWithoutTtlAreNotStored();
+    void freshness();
+    void refreshExtendsExpiry();
+    void invalidateByPrefix();
+    void evictsLeastRecentlyUsed();
+    void clear();
+
+private:
+    static ResponseCache::Entry entry(const QString &path, const QByteArray &body);
+};
+
+/**
+ * 构造一个缓存条目
+ */
+ResponseCache::Entry TestResponseCache::entry(const QString &path, const QByteArray &body)
+{
+    ResponseCache::Entry entry;
+    entry.url = QUrl("http://localhost:8001/api" + path);
+    entry.path = path;
+    entry.body = body;
+    entry.contentType = "application/json";
+    return entry;
+}
+
+void TestResponseCache::ttlUsesLongestPrefix()
+{
+    ResponseCache cache;
+    cache.setTtl("/roles/", 300);
+    cache.setTtl("/roles/permissions", 600);
+    
+    QCOMPARE(cache.ttlFor("/roles/"), 300);
+    QCOMPARE(cache.ttlFor("/roles/5"), 300);
+    QCOMPARE(cache.ttlFor("/roles/permissions/all"), 600);
+    QCOMPARE(cache.ttlFor("/users/"), 0);
+    
+    // 重复设置同一前缀时覆盖原值
+    cache.setTtl("/roles/", 0);
+    QCOMPARE(cache.ttlFor("/roles/5"), 0);
+    QCOMPARE(cache.ttlFor("/roles/permissions/all"), 600);
+}
+
+void TestResponseCache::storeAndLookup()
+{
+    ResponseCache cache;
+    cache.setTtl("/roles/", 300);
+    
+    ResponseCache::Entry stored = entry("/roles/", "[{\"id\":1}]");
+    stored.etag = "\"v1\"";
+    stored.lastModified = "Wed, 01 May 2024 10:00:00 GMT";
+    cache.store("GET /roles/", stored);
+    
+    ResponseCache::Entry found;
+    QVERIFY(cache.lookup("GET /roles/", &found));
+    QCOMPARE(found.url, stored.url);
+    QCOMPARE(found.body, stored.body);
+    QCOMPARE(found.contentType, stored.contentType);
+    QCOMPARE(found.etag, stored.etag);
+    QCOMPARE(found.lastModified, stored.lastModified);
+    QVERIFY(ResponseCache::isFresh(found));
+    
+    QVERIFY(!cache.lookup("GET /roles/?skip=100", &found));
+}
+
+void TestResponseCache::pathsWithoutTtlAreNotStored()
+{
+    ResponseCache cache;
+    cache.setTtl("/roles/", 300);
+    cache.setTtl("/users/", 0);
+    
+    ResponseCache::Entry found;
+    cache.store("GET /users/", entry("/users/", "[]"));
+    QVERIFY(!cache.lookup("GET /users/", &found));
+    cache.store("GET /auth/me", entry("/auth/me", "{}"));
+    QVERIFY(!cache.lookup("GET /auth/me", &found));
+}
+
+void TestResponseCache::freshness()
+{
+    ResponseCache::Entry stale = entry("/roles/", "[]");
+    stale.expiresAt = QDateTime::currentMSecsSinceEpoch() - 1;
+    QVERIFY(!ResponseCache::isFresh(stale));
+    
+    ResponseCache::Entry fresh = entry("/roles/", "[]");
+    fresh.expiresAt = QDateTime::currentMSecsSinceEpoch() + 60 * 1000;
+    QVERIFY(ResponseCache::isFresh(fresh));
+}
+
+void TestResponseCache::refreshExtendsExpiry()
+{
+    ResponseCache cache;
+    cache.setTtl("/roles/", 300);
+    cache.store("GET /roles/", entry("/roles/", "[]"));
+    
+    ResponseCache::Entry before;
+    QVERIFY(cache.lookup("GET /roles/", &before));
+    QTest::qSleep(20);
+    cache.refresh("GET /roles/");
+    
+    ResponseCache::Entry after;
+    QVERIFY(cache.lookup("GET /roles/", &after));
+    QVERIFY(after.expiresAt > before.expiresAt);
+    
+    // 不存在的条目忽略
+    cache.refresh("GET /missing");
+}
+
+void TestResponseCache::invalidateByPrefix()
+{
+    ResponseCache cache;
+    cache.setTtl("/users/", 60);
+    cache.setTtl("/roles/", 300);
+    cache.store("GET /users/1", entry("/users/1", "{}"));
+    cache.store("GET /users/2", entry("/users/2", "{}"));
+    cache.store("GET /roles/", entry("/roles/", "[]"));
+    
+    QList<QUrl> removed = cache.invalidate("/users/");
+    QCOMPARE(removed.size(), 2);
+    QVERIFY(removed.contains(QUrl("http://localhost:8001/api/users/1")));
+    QVERIFY(removed.contains(QUrl("http://localhost:8001/api/users/2")));
+    
+    ResponseCache::Entry found;
+    QVERIFY(!cache.lookup("GET /users/1", &found));
+    QVERIFY(!cache.lookup("GET /users/2", &found));
+    QVERIFY(cache.lookup("GET /roles/", &found));
+    
+    QVERIFY(cache.invalidate("/permissions/").isEmpty());
+}
+
+void TestResponseCache::evictsLeastRecentlyUsed()
+{
+    // 以响应体字节数计算开销
+    ResponseCache cache(10);
+    cache.setTtl("/", 60);
+    
+    ResponseCache::Entry found;
+    cache.store("a", entry("/a", "123456"));
+    cache.store("b", entry("/b", "123456"));
+    QVERIFY(!cache.lookup("a", &found));
+    QVERIFY(cache.lookup("b", &found));
+    
+    // 超过上限的单个响应不缓存
+    cache.store("c", entry("/c", "12345678901"));
+    QVERIFY(!cache.lookup("c", &found));
+}
+
+void TestResponseCache::clear()
+{
+    ResponseCache cache;
+    cache.setTtl("/roles/", 300);
+    cache.store("GET /roles/", entry("/roles/", "[]"));
+    cache.clear();
+    
+    ResponseCache::Entry found;
+    QVERIFY(!cache.lookup("GET /roles/", &found));
+    QCOMPARE(cache.ttlFor("/roles/"), 300);
+}
+
+QTEST_GUILESS_MAIN(TestResponseCache)
+
+#include "tst_responsecache.moc"
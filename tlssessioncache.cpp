@@ -0,0 +1,149 @@
+#include "tlssessioncache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+// 会话文件标识与格式版本
+const quint32 SessionMagic = 0x544c5353;
+const quint16 SessionVersion = 1;
+
+// 服务端未给出有效期时按1小时处理；TLS 1.3规定票据有效期不超过7天
+const int DefaultLifetimeSecs = 60 * 60;
+const int MaxLifetimeSecs = 7 * 24 * 60 * 60;
+
+}
+
+/**
+ * TLS会话缓存构造函数
+ */
+TlsSessionCache::TlsSessionCache()
+    : m_expiresAt(0)
+{
+}
+
+/**
+ * 打开指定服务器的会话文件
+ */
+void TlsSessionCache::open(const QUrl &serverUrl)
+{
+    m_server.clear();
+    m_path.clear();
+    m_session.clear();
+    m_expiresAt = 0;
+    
+    if (serverUrl.scheme() != "https" || serverUrl.host().isEmpty()) {
+        return;
+    }
+    
+    m_server = QString("%1:%2").arg(serverUrl.host()).arg(serverUrl.port(443));
+    QByteArray scope = QCryptographicHash::hash(m_server.toUtf8(), QCryptographicHash::Sha1).toHex();
+    m_path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+             + "/tls/" + QString::fromLatin1(scope) + ".session";
+    
+    if (load()) {
+        qDebug() << "[DEBUG] TlsSessionCache: loaded session for" << m_server << "expires"
+                 << QDateTime::fromMSecsSinceEpoch(m_expiresAt).toString(Qt::ISODate);
+    }
+}
+
+/**
+ * 当前可复用的会话数据
+ */
+QByteArray TlsSessionCache::session() const
+{
+    if (m_session.isEmpty() || QDateTime::currentMSecsSinceEpoch() >= m_expiresAt) {
+        return QByteArray();
+    }
+    return m_session;
+}
+
+/**
+ * 保存握手得到的会话数据，内容未变化时不重复写文件
+ */
+void TlsSessionCache::store(const QByteArray &session, int lifetimeHint)
+{
+    if (m_path.isEmpty() || session.isEmpty() || session == m_session) {
+        return;
+    }
+    
+    int lifetime = lifetimeHint > 0 ? qMin(lifetimeHint, MaxLifetimeSecs) : DefaultLifetimeSecs;
+    m_session = session;
+    m_expiresAt = QDateTime::currentMSecsSinceEpoch() + qint64(lifetime) * 1000;
+    save();
+}
+
+/**
+ * 丢弃当前会话并删除会话文件
+ */
+void TlsSessionCache::clear()
+{
+    m_session.clear();
+    m_expiresAt = 0;
+    if (!m_path.isEmpty()) {
+        QFile::remove(m_path);
+    }
+}
+
+/**
+ * 读取会话文件，格式不符或已过期时删除
+ */
+bool TlsSessionCache::load()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString server;
+    qint64 expiresAt = 0;
+    QByteArray session;
+    in >> magic >> version >> server >> expiresAt >> session;
+    file.close();
+    
+    bool valid = (in.status() == QDataStream::Ok && magic == SessionMagic && version == SessionVersion
+                  && server == m_server && !session.isEmpty());
+    if (!valid || QDateTime::currentMSecsSinceEpoch() >= expiresAt) {
+        QFile::remove(m_path);
+        return false;
+    }
+    
+    m_session = session;
+    m_expiresAt = expiresAt;
+    return true;
+}
+
+/**
+ * 写入会话文件，仅所有者可读写
+ */
+void TlsSessionCache::save()
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "[DEBUG] TlsSessionCache: failed to write" << m_path << file.errorString();
+        return;
+    }
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << SessionMagic << SessionVersion << m_server << m_expiresAt << m_session;
+    
+    if (!file.commit()) {
+        qDebug() << "[DEBUG] TlsSessionCache: failed to commit" << file.errorString();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+
+/**
+ * TLS会话缓存
+ * 保存服务器下发的会话票据，下次启动时用于恢复TLS会话，首个请求省去完整握手。
+ * 每个服务器（协议、主机、端口）一个文件，仅所有者可读写；按服务端给出的有效期过期
+ */
+class TlsSessionCache
+{
+public:
+    TlsSessionCache();
+    
+    /**
+     * 打开指定服务器的会话文件并读取未过期的会话，非https地址不缓存
+     */
+    void open(const QUrl &serverUrl);
+    
+    /**
+     * 当前可复用的会话数据，没有或已过期返回空
+     */
+    QByteArray session() const;
+    
+    /**
+     * 保存握手得到的会话数据，lifetimeHint为服务端给出的有效期（秒），0表示未给出
+     */
+    void store(const QByteArray &session, int lifetimeHint);
+    
+    /**
+     * 丢弃当前会话并删除会话文件
+     */
+    void clear();
+    
+private:
+    bool load();
+    void save();
+    
+    QString m_server;
+    QString m_path;
+    QByteArray m_session;
+    qint64 m_expiresAt;
+};
+
+#endif // TLSSESSIONCACHE_H
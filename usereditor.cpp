@@ -20,19 +20,14 @@ UserEditor::UserEditor(ApiManager *apiManager, QWidget *parent)
     , m_statusLabel(nullptr)
     , m_apiManager(apiManager)
     , m_isEditMode(false)
+    , m_userCreated(false)
+    , m_userRequestPending(false)
+    , m_roleBatchPending(false)
 {
     setWindowTitle("添加用户");
     setupUI();
     setupStyles();
     loadRoles();
-    
-    // 连接API信号
-    connect(m_apiManager, &ApiManager::roleListResult,
-            this, &UserEditor::onRoleListResult);
-    connect(m_apiManager, &ApiManager::registerResult,
-            this, &UserEditor::onRegisterResult);
-    connect(m_apiManager, &ApiManager::networkError,
-            this, &UserEditor::onNetworkError);
 }
 
 /**
@@ -52,6 +47,9 @@ UserEditor::UserEditor(ApiManager *apiManager, const UserInfo &user, QWidget *pa
     , m_apiManager(apiManager)
     , m_originalUser(user)
     , m_isEditMode(true)
+    , m_userCreated(false)
+    , m_userRequestPending(false)
+    , m_roleBatchPending(false)
 {
     setWindowTitle("编辑用户");
     setupUI();
@@ -65,14 +63,6 @@ UserEditor::UserEditor(ApiManager *apiManager, const UserInfo &user, QWidget *pa
     m_fullNameEdit->setText(user.fullName);
     m_isActiveCheck->setChecked(user.isActive);
     m_passwordEdit->setPlaceholderText("留空表示不修改密码");
-    
-    // 连接API信号
-    connect(m_apiManager, &ApiManager::roleListResult,
-            this, &UserEditor::onRoleListResult);
-    connect(m_apiManager, &ApiManager::updateUserResult,
-            this, &UserEditor::onUpdateUserResult);
-    connect(m_apiManager, &ApiManager::networkError,
-            this, &UserEditor::onNetworkError);
 }
 
 /**
@@ -276,7 +266,9 @@ void UserEditor::setupStyles()
 void UserEditor::loadRoles()
 {
     showStatus("正在加载角色列表...");
-    m_apiManager->getRoleList();
+    m_apiManager->getRoleList(0, 100, false)->then(this, [this](ApiReply *reply) {
+        onRoleListResult(reply);
+    });
 }
 
 /**
@@ -370,6 +362,83 @@ void UserEditor::updateUserRoles()
     }
 }
 
+/**
+ * 根据角色ID查找角色名称
+ */
+QString UserEditor::roleNameById(int roleId) const
+{
+    for (const RoleInfo &role : m_availableRoles) {
+        if (role.id == roleId) {
+            return role.name;
+        }
+    }
+    return QString();
+}
+
+/**
+ * 计算角色变更
+ */
+QList<BatchOperation> UserEditor::computeRoleChanges(int userId) const
+{
+    QList<BatchOperation> changes;
+    
+    for (int i = 0; i < m_rolesList->count(); ++i) {
+        QListWidgetItem *item = m_rolesList->item(i);
+        int roleId = item->data(Qt::UserRole).toInt();
+        bool hadRole = m_originalUser.roles.contains(roleNameById(roleId));
+        
+        if (item->isSelected() && !hadRole) {
+            changes.append({BatchOperation::AssignRole, userId, roleId});
+        } else if (!item->isSelected() && hadRole) {
+            changes.append({BatchOperation::RemoveRole, userId, roleId});
+        }
+    }
+    
+    return changes;
+}
+
+/**
+ * 提交角色变更批次
+ */
+bool UserEditor::submitRoleChanges(int userId)
+{
+    QList<BatchOperation> changes = computeRoleChanges(userId);
+    if (changes.isEmpty()) {
+        return false;
+    }
+    
+    showStatus(QString("正在同步角色 (0/%1)...").arg(changes.size()));
+    m_submittedRoleChanges = changes;
+    m_roleBatchPending = true;
+    
+    // 角色修改由用户保存触发，走交互队列，不排在后台同步之后
+    ApiReply *reply = m_apiManager->submitBatch(changes, ApiManager::Interactive);
+    connect(reply, &ApiReply::progress, this, &UserEditor::onBatchProgress);
+    reply->then(this, [this](ApiReply *batchReply) {
+        onBatchFinished(batchReply);
+    });
+    return true;
+}
+
+/**
+ * 用户请求与角色批次都完成后统一收尾
+ */
+void UserEditor::finishIfDone()
+{
+    if (m_userRequestPending || m_roleBatchPending) {
+        return;
+    }
+    
+    m_okButton->setEnabled(true);
+    
+    if (m_saveErrors.isEmpty()) {
+        showStatus(m_isEditMode && !m_userCreated ? "用户更新成功" : "用户创建成功");
+        accept();
+    } else {
+        showStatus(m_saveErrors.join("\n"), true);
+    }
+}
+
 /**
  * 获取编辑后的用户信息
  */
@@ -415,13 +484,27 @@ void UserEditor::onOkClicked()
     bool isActive = m_isActiveCheck->isChecked();
     
     m_okButton->setEnabled(false);
+    m_saveErrors.clear();
     
-    if (m_isEditMode) {
+    if (m_userCreated) {
+        // 用户已创建，只重试未成功的角色分配；没有用户ID时无法分配，直接关闭
+        if (m_originalUser.id <= 0 || !submitRoleChanges(m_originalUser.id)) {
+            finishIfDone();
+        }
+    } else if (m_isEditMode) {
+        // 用户信息与角色变更同时发出，整体只等待一次往返
         showStatus("正在更新用户...");
-        m_apiManager->updateUser(m_originalUser.id, email, fullName, isActive);
+        m_userRequestPending = true;
+        m_apiManager->updateUser(m_originalUser.id, email, fullName, isActive)->then(this, [this](ApiReply *reply) {
+            onUpdateUserResult(reply);
+        });
+        submitRoleChanges(m_originalUser.id);
     } else {
         showStatus("正在创建用户...");
-        m_apiManager->registerUser(username, email, password, fullName);
+        m_userRequestPending = true;
+        m_apiManager->registerUser(username, email, password, fullName)->then(this, [this](ApiReply *reply) {
+            onRegisterResult(reply);
+        });
     }
 }
 
@@ -436,13 +519,13 @@ void UserEditor::onCancelClicked()
 /**
  * 角色列表结果处理
  */
-void UserEditor::onRoleListResult(bool success, const QList<RoleInfo> &roles, const QString &error)
+void UserEditor::onRoleListResult(ApiReply *reply)
 {
-    if (success) {
-        m_availableRoles = roles;
+    if (reply->isSuccess()) {
+        m_availableRoles = reply->value<QList<RoleInfo>>();
         m_rolesList->clear();
         
-        for (const RoleInfo &role : roles) {
+        for (const RoleInfo &role : m_availableRoles) {
             QListWidgetItem *item = new QListWidgetItem(role.displayName, m_rolesList);
             item->setData(Qt::UserRole, role.id);
             item->setToolTip(role.description);
@@ -451,46 +534,109 @@ void UserEditor::onRoleListResult(bool success, const QList<RoleInfo> &roles, co
         updateUserRoles();
         showStatus("角色列表加载完成");
     } else {
-        showStatus("加载角色列表失败: " + error, true);
+        showStatus("加载角色列表失败: " + reply->error(), true);
     }
 }
 
 /**
  * 用户注册结果处理
  */
-void UserEditor::onRegisterResult(bool success, const QString &message)
+void UserEditor::onRegisterResult(ApiReply *reply)
 {
-    m_okButton->setEnabled(true);
+    m_userRequestPending = false;
     
-    if (success) {
-        showStatus("用户创建成功");
-        accept();
-    } else {
-        showStatus("创建用户失败: " + message, true);
+    if (!reply->isSuccess()) {
+        m_okButton->setEnabled(true);
+        showStatus("创建用户失败: " + reply->error(), true);
+        return;
+    }
+    
+    // 新用户创建后再分配所选角色；此后对话框转为编辑该用户，再次确定不会重复创建
+    UserInfo user = reply->value<UserInfo>();
+    m_originalUser = user;
+    m_isEditMode = true;
+    m_userCreated = true;
+    m_usernameEdit->setEnabled(false);
+    m_passwordEdit->setEnabled(false);
+    m_okButton->setText("重试角色分配");
+    
+    if (user.id > 0) {
+        submitRoleChanges(user.id);
+    } else if (!computeRoleChanges(0).isEmpty()) {
+        m_saveErrors.append("用户已创建，但服务器未返回用户ID，所选角色未分配，请在用户列表中编辑该用户分配角色");
     }
+    finishIfDone();
 }
 
 /**
  * 用户更新结果处理
  */
-void UserEditor::onUpdateUserResult(bool success, const UserInfo &user, const QString &error)
+void UserEditor::onUpdateUserResult(ApiReply *reply)
 {
-    Q_UNUSED(user)
-    m_okButton->setEnabled(true);
+    m_userRequestPending = false;
     
-    if (success) {
-        showStatus("用户更新成功");
-        accept();
-    } else {
-        showStatus("更新用户失败: " + error, true);
+    if (!reply->isSuccess()) {
+        m_saveErrors.append("更新用户失败: " + reply->error());
     }
+    finishIfDone();
 }
 
 /**
- * 网络错误处理
+ * 角色变更批次进度处理
  */
-void UserEditor::onNetworkError(const QString &error)
+void UserEditor::onBatchProgress(int completed, int total)
 {
-    m_okButton->setEnabled(true);
-    showStatus("网络错误: " + error, true);
+    showStatus(QString("正在同步角色 (%1/%2)...").arg(completed).arg(total));
+}
+
+/**
+ * 角色变更批次完成处理
+ * 成功的变更计入原始角色，失败的变更在界面上回滚到服务器状态，
+ * 这样再次点击确定时只会重试失败的部分
+ */
+void UserEditor::onBatchFinished(ApiReply *reply)
+{
+    m_roleBatchPending = false;
+    
+    BatchResult batchResult = reply->value<BatchResult>();
+    const QList<BatchOperation> &failed = batchResult.failed;
+    const QStringList &errors = batchResult.errors;
+    
+    for (const BatchOperation &operation : m_submittedRoleChanges) {
+        bool operationFailed = false;
+        for (const BatchOperation &failedOperation : failed) {
+            if (failedOperation.roleId == operation.roleId && failedOperation.type == operation.type) {
+                operationFailed = true;
+                break;
+            }
+        }
+        if (operationFailed) {
+            continue;
+        }
+        
+        QString roleName = roleNameById(operation.roleId);
+        if (operation.type == BatchOperation::AssignRole) {
+            m_originalUser.roles.append(roleName);
+        } else {
+            m_originalUser.roles.removeAll(roleName);
+        }
+    }
+    
+    if (!failed.isEmpty()) {
+        QStringList rolledBack;
+        for (int i = 0; i < failed.size(); ++i) {
+            rolledBack.append(QString("%1(%2)").arg(roleNameById(failed[i].roleId), errors.value(i)));
+        }
+        m_saveErrors.append(QString("%1 项角色变更失败，已恢复原状态: %2")
+                            .arg(failed.size()).arg(rolledBack.join(", ")));
+        
+        // 回滚界面选择
+        for (int i = 0; i < m_rolesList->count(); ++i) {
+            QListWidgetItem *item = m_rolesList->item(i);
+            int roleId = item->data(Qt::UserRole).toInt();
+            item->setSelected(m_originalUser.roles.contains(roleNameById(roleId)));
+        }
+    }
+    
+    finishIfDone();
 }
\ No newline at end of file
@@ -43,22 +43,27 @@ private slots:
     /**
      * 角色列表结果处理
      */
-    void onRoleListResult(bool success, const QList<RoleInfo> &roles, const QString &error);
+    void onRoleListResult(ApiReply *reply);
     
     /**
      * 用户注册结果处理
      */
-    void onRegisterResult(bool success, const QString &message);
+    void onRegisterResult(ApiReply *reply);
     
     /**
      * 用户更新结果处理
      */
-    void onUpdateUserResult(bool success, const UserInfo &user, const QString &error);
+    void onUpdateUserResult(ApiReply *reply);
     
     /**
-     * 网络错误处理
+     * 角色变更批次进度处理
      */
-    void onNetworkError(const QString &error);
+    void onBatchProgress(int completed, int total);
+    
+    /**
+     * 角色变更批次完成处理
+     */
+    void onBatchFinished(ApiReply *reply);
 
 private:
     /**
@@ -90,6 +95,26 @@ private:
      * 更新用户角色显示
      */
     void updateUserRoles();
+    
+    /**
+     * 计算角色变更（与原始角色对比得到需要分配/移除的角色）
+     */
+    QList<BatchOperation> computeRoleChanges(int userId) const;
+    
+    /**
+     * 提交角色变更批次，没有变更时返回false
+     */
+    bool submitRoleChanges(int userId);
+    
+    /**
+     * 根据角色ID查找角色名称
+     */
+    QString roleNameById(int roleId) const;
+    
+    /**
+     * 用户请求与角色批次都完成后统一收尾
+     */
+    void finishIfDone();
 
 private:
     // UI组件
@@ -108,6 +133,13 @@ private:
     UserInfo m_originalUser;
     QList<RoleInfo> m_availableRoles;
     bool m_isEditMode;
+    bool m_userCreated;     // 新建模式下用户已创建，再次确定时只重试角色分配
+    
+    // 保存状态
+    bool m_userRequestPending;
+    bool m_roleBatchPending;
+    QList<BatchOperation> m_submittedRoleChanges;
+    QStringList m_saveErrors;
 };
 
 #endif // USEREDITOR_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "usermanager.h"
 #include "usereditor.h"
+#include "entitystore.h"
 #include <QHeaderView>
 #include <QSplitter>
 #include <QGroupBox>
@@ -8,7 +9,7 @@
 #include <QApplication>
 #include <QDateTime>
 #include <QMessageBox>
-#include <QShowEvent>
+#include <QSettings>
 
 /**
  * 用户管理器构造函数
@@ -21,12 +22,15 @@ UserManager::UserManager(ApiManager *apiManager, QWidget *parent)
     , m_deleteButton(nullptr)
     , m_refreshButton(nullptr)
     , m_searchButton(nullptr)
+    , m_bulkActivateButton(nullptr)
+    , m_bulkDeactivateButton(nullptr)
+    , m_bulkAssignRoleButton(nullptr)
+    , m_retryFailedButton(nullptr)
     , m_searchEdit(nullptr)
     , m_statusLabel(nullptr)
     , m_totalLabel(nullptr)
+    , m_bulkProgressBar(nullptr)
     , m_apiManager(apiManager)
-    , m_currentPage(0)
-    , m_pageSize(50)
     , m_totalUsers(0)
     , m_firstShow(true)
 {
@@ -34,17 +38,9 @@ UserManager::UserManager(ApiManager *apiManager, QWidget *parent)
     setupStyles();
     setupTable();
     
-    // 连接API信号
-    connect(m_apiManager, &ApiManager::userListResult,
-            this, &UserManager::onUserListResult);
-    connect(m_apiManager, &ApiManager::userInfoResult,
-            this, &UserManager::onUserInfoResult);
-    connect(m_apiManager, &ApiManager::registerResult,
-            this, &UserManager::onRegisterResult);
-    connect(m_apiManager, &ApiManager::updateUserResult,
-            this, &UserManager::onUpdateUserResult);
-    connect(m_apiManager, &ApiManager::networkError,
-            this, &UserManager::onNetworkError);
+    // 用户目录由同步与推送维护，变化时刷新表格
+    connect(m_apiManager->entityStore(), &EntityStore::usersChanged,
+            this, &UserManager::onStoreUsersChanged);
     
     // 不在构造时加载用户列表，等待登录成功后再加载
     // refreshUserList();
@@ -58,15 +54,24 @@ UserManager::~UserManager()
 }
 
 /**
- * 显示事件，首次显示时自动加载数据
+ * 页面激活，首次激活时自动加载数据
+ * 页面切走后保持存活，再次激活时直接显示已加载的数据
  */
-void UserManager::showEvent(QShowEvent *event)
+void UserManager::activateTool()
 {
-    QWidget::showEvent(event);
-    
     if (m_firstShow) {
         m_firstShow = false;
         refreshUserList();
+        
+        // 先显示上次保存的快照，服务器数据返回后再替换
+        EntityStore *store = m_apiManager->entityStore();
+        if (store->hasSnapshot() && !store->users().isEmpty()) {
+            m_users = store->users();
+            m_totalUsers = m_users.size();
+            updateTable();
+            showStatus(QString("显示 %1 的数据，正在同步...")
+                       .arg(store->snapshotTime().toString("yyyy-MM-dd hh:mm")));
+        }
     }
 }
 
@@ -104,6 +109,23 @@ void UserManager::setupUI()
     
     mainLayout->addLayout(toolbarLayout);
     
+    // 批量操作栏
+    QHBoxLayout *bulkLayout = new QHBoxLayout();
+    QLabel *bulkLabel = new QLabel("批量操作:", this);
+    m_bulkActivateButton = new QPushButton("批量激活", this);
+    m_bulkDeactivateButton = new QPushButton("批量禁用", this);
+    m_bulkAssignRoleButton = new QPushButton("批量分配角色", this);
+    m_retryFailedButton = new QPushButton("重试失败项", this);
+    
+    bulkLayout->addWidget(bulkLabel);
+    bulkLayout->addWidget(m_bulkActivateButton);
+    bulkLayout->addWidget(m_bulkDeactivateButton);
+    bulkLayout->addWidget(m_bulkAssignRoleButton);
+    bulkLayout->addStretch();
+    bulkLayout->addWidget(m_retryFailedButton);
+    
+    mainLayout->addLayout(bulkLayout);
+    
     // 用户表格
     m_userTable = new QTableWidget(this);
     mainLayout->addWidget(m_userTable);
@@ -112,9 +134,13 @@ void UserManager::setupUI()
     QHBoxLayout *statusLayout = new QHBoxLayout();
     m_statusLabel = new QLabel("就绪", this);
     m_totalLabel = new QLabel("总计: 0 个用户", this);
+    m_bulkProgressBar = new QProgressBar(this);
+    m_bulkProgressBar->setMaximumWidth(200);
+    m_bulkProgressBar->setVisible(false);
     
     statusLayout->addWidget(m_statusLabel);
     statusLayout->addStretch();
+    statusLayout->addWidget(m_bulkProgressBar);
     statusLayout->addWidget(m_totalLabel);
     
     mainLayout->addLayout(statusLayout);
@@ -130,6 +156,14 @@ void UserManager::setupUI()
             this, &UserManager::onRefreshClicked);
     connect(m_searchButton, &QPushButton::clicked,
             this, &UserManager::onSearchClicked);
+    connect(m_bulkActivateButton, &QPushButton::clicked,
+            this, &UserManager::onBulkActivateClicked);
+    connect(m_bulkDeactivateButton, &QPushButton::clicked,
+            this, &UserManager::onBulkDeactivateClicked);
+    connect(m_bulkAssignRoleButton, &QPushButton::clicked,
+            this, &UserManager::onBulkAssignRoleClicked);
+    connect(m_retryFailedButton, &QPushButton::clicked,
+            this, &UserManager::onRetryFailedClicked);
     
     connect(m_searchEdit, &QLineEdit::returnPressed,
             this, &UserManager::onSearchClicked);
@@ -167,6 +201,9 @@ void UserManager::setupStyles()
     m_addButton->setStyleSheet(buttonStyle);
     m_refreshButton->setStyleSheet(buttonStyle);
     m_searchButton->setStyleSheet(buttonStyle);
+    m_bulkActivateButton->setStyleSheet(buttonStyle);
+    m_bulkAssignRoleButton->setStyleSheet(buttonStyle);
+    m_retryFailedButton->setStyleSheet(buttonStyle);
     
     QString editButtonStyle = buttonStyle;
     editButtonStyle.replace("#0078d4", "#f39c12");
@@ -179,6 +216,7 @@ void UserManager::setupStyles()
     deleteButtonStyle.replace("#106ebe", "#c0392b");
     deleteButtonStyle.replace("#005a9e", "#a93226");
     m_deleteButton->setStyleSheet(deleteButtonStyle);
+    m_bulkDeactivateButton->setStyleSheet(deleteButtonStyle);
     
     // 设置搜索框样式
     m_searchEdit->setStyleSheet("QLineEdit { "
@@ -212,7 +250,7 @@ void UserManager::setupTable()
     
     // 设置表格属性
     m_userTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    m_userTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_userTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     m_userTable->setAlternatingRowColors(true);
     m_userTable->setSortingEnabled(true);
     
@@ -257,7 +295,15 @@ void UserManager::setupTable()
 void UserManager::refreshUserList()
 {
     showStatus("正在加载用户列表...");
-    m_apiManager->getUserList(m_currentPage * m_pageSize, m_pageSize);
+    
+    // 新的刷新取代尚未返回的旧请求，避免旧结果覆盖新结果
+    if (m_userListReply) {
+        m_userListReply->cancel();
+    }
+    m_userListReply = m_apiManager->syncUsers(ApiManager::Interactive);
+    m_userListReply->then(this, [this](ApiReply *reply) {
+        onUserListResult(reply);
+    });
 }
 
 /**
@@ -326,6 +372,14 @@ void UserManager::updateButtonStates()
     bool hasSelection = m_userTable->currentRow() >= 0;
     m_editButton->setEnabled(hasSelection);
     m_deleteButton->setEnabled(hasSelection);
+    
+    // 批量操作进行中时禁止再次提交
+    bool bulkIdle = m_bulkReply.isNull();
+    bool hasBulkSelection = !m_userTable->selectionModel()->selectedRows().isEmpty();
+    m_bulkActivateButton->setEnabled(bulkIdle && hasBulkSelection);
+    m_bulkDeactivateButton->setEnabled(bulkIdle && hasBulkSelection);
+    m_bulkAssignRoleButton->setEnabled(bulkIdle && hasBulkSelection);
+    m_retryFailedButton->setEnabled(bulkIdle && !m_failedOperations.isEmpty());
 }
 
 /**
@@ -333,13 +387,73 @@ void UserManager::updateButtonStates()
  */
 UserInfo UserManager::getSelectedUser() const
 {
-    int row = m_userTable->currentRow();
-    if (row >= 0 && row < m_users.size()) {
-        return m_users[row];
+    return userAtRow(m_userTable->currentRow());
+}
+
+/**
+ * 获取表格中某一行对应的用户
+ * 表格可排序、也可能显示的是搜索结果，因此按ID列查找而不是按行号索引m_users
+ */
+UserInfo UserManager::userAtRow(int row) const
+{
+    QTableWidgetItem *idItem = row >= 0 ? m_userTable->item(row, 0) : nullptr;
+    if (!idItem) {
+        return UserInfo();
+    }
+    
+    int userId = idItem->text().toInt();
+    for (const UserInfo &user : m_users) {
+        if (user.id == userId) {
+            return user;
+        }
     }
     return UserInfo();
 }
 
+/**
+ * 获取所有选中的用户ID
+ * 表格可排序，因此从ID列读取而不是按行号索引m_users
+ */
+QList<int> UserManager::getSelectedUserIds() const
+{
+    QList<int> userIds;
+    const QModelIndexList rows = m_userTable->selectionModel()->selectedRows();
+    for (const QModelIndex &index : rows) {
+        QTableWidgetItem *idItem = m_userTable->item(index.row(), 0);
+        if (idItem) {
+            userIds.append(idItem->text().toInt());
+        }
+    }
+    return userIds;
+}
+
+/**
+ * 开始批量操作
+ */
+void UserManager::startBulkOperation(const QList<BatchOperation> &operations, const QString &description)
+{
+    if (operations.isEmpty() || m_bulkReply) {
+        return;
+    }
+    
+    m_failedOperations.clear();
+    m_bulkProgressBar->setRange(0, operations.size());
+    m_bulkProgressBar->setValue(0);
+    m_bulkProgressBar->setVisible(true);
+    showStatus(QString("正在%1 (0/%2)...").arg(description).arg(operations.size()));
+    
+    // 限制并发与速率，避免数千个请求同时压到后端
+    QSettings settings;
+    int maxConcurrent = qMax(0, settings.value("network/batch_max_concurrent", 8).toInt());
+    int maxPerSecond = qMax(0, settings.value("network/batch_rate_limit", 100).toInt());
+    m_bulkReply = m_apiManager->submitBatch(operations, ApiManager::Background, maxConcurrent, maxPerSecond);
+    connect(m_bulkReply, &ApiReply::progress, this, &UserManager::onBatchProgress);
+    m_bulkReply->then(this, [this](ApiReply *reply) {
+        onBatchFinished(reply);
+    });
+    updateButtonStates();
+}
+
 /**
  * 显示状态信息
  */
@@ -398,6 +512,8 @@ void UserManager::onDeleteUserClicked()
  */
 void UserManager::onRefreshClicked()
 {
+    // 手动刷新跳过缓存，直接从服务器获取最新数据
+    m_apiManager->invalidateCache("/users/");
     refreshUserList();
 }
 
@@ -430,65 +546,159 @@ void UserManager::onSearchClicked()
     showStatus(QString("搜索到 %1 个匹配的用户").arg(filteredUsers.size()));
 }
 
+/**
+ * 批量激活按钮点击事件
+ */
+void UserManager::onBulkActivateClicked()
+{
+    QList<BatchOperation> operations;
+    for (int userId : getSelectedUserIds()) {
+        operations.append({BatchOperation::SetUserActive, userId, 0, true});
+    }
+    startBulkOperation(operations, "批量激活用户");
+}
+
+/**
+ * 批量禁用按钮点击事件
+ */
+void UserManager::onBulkDeactivateClicked()
+{
+    QList<int> userIds = getSelectedUserIds();
+    if (userIds.isEmpty()) {
+        return;
+    }
+    
+    int ret = QMessageBox::question(this, "确认禁用",
+                                   QString("确定要禁用选中的 %1 个用户吗?").arg(userIds.size()),
+                                   QMessageBox::Yes | QMessageBox::No,
+                                   QMessageBox::No);
+    if (ret != QMessageBox::Yes) {
+        return;
+    }
+    
+    QList<BatchOperation> operations;
+    for (int userId : userIds) {
+        operations.append({BatchOperation::SetUserActive, userId, 0, false});
+    }
+    startBulkOperation(operations, "批量禁用用户");
+}
+
+/**
+ * 批量分配角色按钮点击事件
+ * 先加载角色列表，在结果处理中让用户选择要分配的角色
+ */
+void UserManager::onBulkAssignRoleClicked()
+{
+    QList<int> userIds = getSelectedUserIds();
+    if (userIds.isEmpty()) {
+        return;
+    }
+    
+    showStatus("正在加载角色列表...");
+    m_apiManager->getRoleList(0, 1000, false)->then(this, [this, userIds](ApiReply *reply) {
+        onRoleListResult(reply, userIds);
+    });
+}
+
+/**
+ * 重试失败项按钮点击事件
+ */
+void UserManager::onRetryFailedClicked()
+{
+    startBulkOperation(m_failedOperations, "重试失败的操作");
+}
+
 /**
  * 用户列表结果处理
  */
-void UserManager::onUserListResult(bool success, const QList<UserInfo> &users, const QString &error)
+void UserManager::onUserListResult(ApiReply *reply)
 {
-    if (success) {
-        m_users = users;
-        m_totalUsers = users.size();
-        updateTable();
+    if (reply->isSuccess()) {
+        // 表格已在onStoreUsersChanged中更新
         showStatus("用户列表加载完成");
     } else {
-        showStatus("加载用户列表失败: " + error, true);
+        showStatus("加载用户列表失败: " + reply->error(), true);
     }
 }
 
 /**
- * 用户信息结果处理
+ * 本地存储中的用户目录变化
+ * 正在搜索时保持搜索结果
  */
-void UserManager::onUserInfoResult(bool success, const UserInfo &user, const QString &error)
+void UserManager::onStoreUsersChanged()
 {
-    if (success) {
-        showStatus("用户信息获取成功");
+    m_users = m_apiManager->entityStore()->users();
+    m_totalUsers = m_users.size();
+    if (m_searchEdit->text().trimmed().isEmpty()) {
+        updateTable();
     } else {
-        showStatus("获取用户信息失败: " + error, true);
+        onSearchClicked();
     }
 }
 
 /**
- * 用户注册结果处理
+ * 角色列表结果处理（批量分配角色时选择角色）
  */
-void UserManager::onRegisterResult(bool success, const QString &message)
+void UserManager::onRoleListResult(ApiReply *reply, const QList<int> &userIds)
 {
-    if (success) {
-        showStatus("用户创建成功");
-        refreshUserList();
-    } else {
-        showStatus("创建用户失败: " + message, true);
+    if (!reply->isSuccess()) {
+        showStatus("加载角色列表失败: " + reply->error(), true);
+        return;
+    }
+    
+    QList<RoleInfo> roles = reply->value<QList<RoleInfo>>();
+    QStringList roleNames;
+    for (const RoleInfo &role : roles) {
+        roleNames.append(role.displayName.isEmpty() ? role.name : role.displayName);
+    }
+    
+    bool ok = false;
+    QString selected = QInputDialog::getItem(this, "批量分配角色",
+                                             QString("为选中的 %1 个用户分配角色:").arg(userIds.size()),
+                                             roleNames, 0, false, &ok);
+    int roleIndex = roleNames.indexOf(selected);
+    if (!ok || roleIndex < 0) {
+        showStatus("已取消批量分配角色");
+        return;
+    }
+    
+    QList<BatchOperation> operations;
+    for (int userId : userIds) {
+        operations.append({BatchOperation::AssignRole, userId, roles[roleIndex].id});
     }
+    startBulkOperation(operations, "批量分配角色");
 }
 
 /**
- * 用户更新结果处理
+ * 批量操作进度处理
  */
-void UserManager::onUpdateUserResult(bool success, const UserInfo &user, const QString &error)
+void UserManager::onBatchProgress(int completed, int total)
 {
-    if (success) {
-        showStatus("用户更新成功");
-        refreshUserList();
-    } else {
-        showStatus("更新用户失败: " + error, true);
-    }
+    m_bulkProgressBar->setValue(completed);
+    showStatus(QString("批量操作进行中 (%1/%2)...").arg(completed).arg(total));
 }
 
 /**
- * 网络错误处理
+ * 批量操作完成处理
  */
-void UserManager::onNetworkError(const QString &error)
+void UserManager::onBatchFinished(ApiReply *reply)
 {
-    showStatus("网络错误: " + error, true);
+    BatchResult batchResult = reply->value<BatchResult>();
+    int total = m_bulkProgressBar->maximum();
+    m_bulkReply = nullptr;
+    m_failedOperations = batchResult.failed;
+    m_bulkProgressBar->setVisible(false);
+    
+    if (batchResult.failed.isEmpty()) {
+        showStatus(QString("批量操作完成，共 %1 项").arg(total));
+    } else {
+        showStatus(QString("批量操作完成，成功 %1 项，失败 %2 项（%3），可点击“重试失败项”")
+                   .arg(total - batchResult.failed.size()).arg(batchResult.failed.size())
+                   .arg(batchResult.errors.value(0)), true);
+    }
+    
+    updateButtonStates();
+    refreshUserList();
 }
 
 /**
@@ -505,8 +715,9 @@ void UserManager::onUserTableSelectionChanged()
 void UserManager::onUserTableDoubleClicked(int row, int column)
 {
     Q_UNUSED(column)
-    if (row >= 0 && row < m_users.size()) {
-        showUserEditDialog(m_users[row]);
+    UserInfo user = userAtRow(row);
+    if (user.id > 0) {
+        showUserEditDialog(user);
     }
 }
 
@@ -523,8 +734,8 @@ void UserManager::showUserEditDialog(const UserInfo &user)
     }
     
     if (editor->exec() == QDialog::Accepted) {
-        // 对话框已经处理了API调用，这里不需要额外操作
-        // 刷新将在API响应处理中进行
+        // 对话框在用户信息和角色变更都完成后才会接受，此时刷新一次即可
+        refreshUserList();
     }
     
     editor->deleteLater();
@@ -14,7 +14,10 @@
 #include <QHeaderView>
 #include <QComboBox>
 #include <QCheckBox>
+#include <QProgressBar>
+#include <QPointer>
 #include "apimanager.h"
+#include "itool.h"
 
 QT_BEGIN_NAMESPACE
 class QTableWidget;
@@ -23,21 +26,22 @@ class QLineEdit;
 class QLabel;
 class QComboBox;
 class QCheckBox;
+class QProgressBar;
 QT_END_NAMESPACE
 
-class UserManager : public QWidget
+class UserManager : public QWidget, public IToolPage
 {
     Q_OBJECT
+    Q_INTERFACES(IToolPage)
 
 public:
     explicit UserManager(ApiManager *apiManager, QWidget *parent = nullptr);
     ~UserManager();
 
-protected:
     /**
-     * 显示事件，首次显示时自动加载数据
+     * 页面激活，首次激活时自动加载数据
      */
-    void showEvent(QShowEvent *event) override;
+    void activateTool() override;
 
 public slots:
     /**
@@ -53,12 +57,20 @@ private slots:
     void onRefreshClicked();
     void onSearchClicked();
     
+    // 批量操作
+    void onBulkActivateClicked();
+    void onBulkDeactivateClicked();
+    void onBulkAssignRoleClicked();
+    void onRetryFailedClicked();
+    
     // API响应处理
-    void onUserListResult(bool success, const QList<UserInfo> &users, const QString &error);
-    void onUserInfoResult(bool success, const UserInfo &user, const QString &error);
-    void onRegisterResult(bool success, const QString &message);
-    void onUpdateUserResult(bool success, const UserInfo &user, const QString &error);
-    void onNetworkError(const QString &error);
+    void onUserListResult(ApiReply *reply);
+    void onRoleListResult(ApiReply *reply, const QList<int> &userIds);
+    void onBatchProgress(int completed, int total);
+    void onBatchFinished(ApiReply *reply);
+    
+    // 本地存储中的用户目录变化（同步或推送）
+    void onStoreUsersChanged();
     
     // 表格事件
     void onUserTableSelectionChanged();
@@ -72,20 +84,28 @@ private:
     QPushButton *m_deleteButton;
     QPushButton *m_refreshButton;
     QPushButton *m_searchButton;
+    QPushButton *m_bulkActivateButton;
+    QPushButton *m_bulkDeactivateButton;
+    QPushButton *m_bulkAssignRoleButton;
+    QPushButton *m_retryFailedButton;
     QLineEdit *m_searchEdit;
     QLabel *m_statusLabel;
     QLabel *m_totalLabel;
+    QProgressBar *m_bulkProgressBar;
     
     // API管理器
     ApiManager *m_apiManager;
     
     // 数据
     QList<UserInfo> m_users;
-    int m_currentPage;
-    int m_pageSize;
     int m_totalUsers;
     bool m_firstShow;
     
+    // 进行中的请求
+    QPointer<ApiReply> m_userListReply;
+    QPointer<ApiReply> m_bulkReply;
+    QList<BatchOperation> m_failedOperations;
+    
     // 初始化UI
     void setupUI();
     
@@ -101,9 +121,18 @@ private:
     // 更新按钮状态
     void updateButtonStates();
     
+    // 获取表格中某一行对应的用户
+    UserInfo userAtRow(int row) const;
+    
     // 获取选中的用户
     UserInfo getSelectedUser() const;
     
+    // 获取所有选中的用户ID
+    QList<int> getSelectedUserIds() const;
+    
+    // 开始批量操作
+    void startBulkOperation(const QList<BatchOperation> &operations, const QString &description);
+    
     // 显示用户编辑对话框
     void showUserEditDialog(const UserInfo &user = UserInfo());
     